@@ -8,857 +8,35 @@
 
 //C++の標準ライブラリ
 #include <unistd.h>
+#include <getopt.h>
 #include <stdlib.h>
+#include <string.h>
+#include <cerrno>
 #include <string>
 #include <vector>
 #include <iostream>
 #include <fstream>
-#include <map>
-#include <random>
 #include <algorithm>
-#include <cctype>
+#include <thread>
 #include <boost/algorithm/string.hpp>
 
-//オプションの判定に用いる定数
-#define BIT(num) ((unsigned int)1 << (num))
-#define NORMAL_MODE 0                       //(0000 0000 0000 0000)
-#define SHOW_TRANSITION_MODE BIT(0)         //(0000 0000 0000 0001)
-#define SHOW_DEFAULT_KEY_ARRAY_MODE BIT(1)  //(0000 0000 0000 0010)
-#define SHOW_KEY_ARRAY_MODE BIT(2)          //(0000 0000 0000 0100)
-#define READ_FILE_MODE BIT(3)               //(0000 0000 0000 1000)
-#define OUT_FILE_MODE BIT(4)                //(0000 0000 0001 0000)
-
-//コピーコンストラクタと=演算子関数を無効にするためのマクロ
-#define DISALLOW_COPY_AND_ASSIGN(Typename)		\
-  Typename(const Typename&);					\
-  void operator=(const Typename&)
-
-//関数オブジェクトの定義
-struct ToUpper {
-  char operator()(char c){
-	return toupper(c);
-  }
-};
-struct IsDigit {
-  char operator()(char c){
-	return isdigit(c);
-  }
-};
+#include "enigma.h"
+#include "enigma_attack.h"
+#include "enigma_shard.h"
 
 //プロトタイプ宣言
-std::map<char, int> Alpha2AlphaID();
-std::map<int, char> AlphaID2Alpha();
 [[noreturn]] void ShowUsage();
 
 /**
- * @class  Arguments
- * @brief コマンドライン引数の情報を格納
- */
-class Arguments{
-private:
-  std::string key_;           //エニグマのキーを格納するための変数(default:AAA)
-  std::string code_;          //暗号化（平文化）する文を格納するための変数
-  std::string in_file_name_;  //入力ファイル名を格納するための変数
-  std::string out_file_name_; //出力ファイル名を格納するための変数
-  unsigned int mode_;         //オプションを格納するための変数
-  DISALLOW_COPY_AND_ASSIGN(Arguments);
-public:
-  /**
-   * デフォルトコンストラクタ
-   */
-  Arguments(){
-	key_ = "OOO";
-	code_ = "";
-	in_file_name_ = "";
-	out_file_name_ = "";
-	mode_ = NORMAL_MODE;
-  }
-        
-  /**
-   * デストラクタ
-   */
-  ~Arguments(){
-  }
-        
-  /**
-   * @brief key_に対するgetアクセサ
-   * @param なし
-   * @return key_の値
-   */
-  inline std::string getKey() const{
-	return key_;
-  }
-        
-  /**
-   * @brief key_に対するsetアクセサ
-   * @param [in] key key_にセットする値
-   * @return なし
-   */
-  inline void setKey(const std::string key){
-	key_ = key;
-  }
-        
-  /**
-   * @brief code_に対するgetアクセサ
-   * @param なし
-   * @return code_の値
-   */
-  inline std::string getCode() const{
-	return code_;
-  }
-        
-  /**
-   * @brief code_に対するsetアクセサ
-   * @param [in] code code_にセットする値
-   * @return なし
-   */
-  inline void setCode(const std::string code){
-	code_ = code;
-  }
-        
-  /**
-   * @brief in_file_name_に対するgetアクセサ
-   * @param なし
-   * @return in_file_name_の値
-   */
-  inline std::string getInFileName() const{
-	return in_file_name_;
-  }
-        
-  /**
-   * @brief in_file_name_に対するsetアクセサ
-   * @param [in] in_file_name in_file_name_にセットする値
-   * @return なし
-   */
-  inline void setInFileName(const std::string in_file_name){
-	in_file_name_ = in_file_name;
-  }
-        
-  /**
-   * @brief out_file_name_に対するgetアクセサ
-   * @param なし
-   * @return out_file_name_の値
-   */
-  inline std::string getOutFileName() const{
-	return out_file_name_;
-  }
-        
-  /**
-   * @brief out_file_name_に対するsetアクセサ
-   * @param [in] out_file_name out_file_name_にセットする値
-   * @return なし
-   */
-  inline void setOutFileName(const std::string out_file_name){
-	out_file_name_ = out_file_name;
-  }
-        
-  /**
-   * @brief mode_に対するgetアクセサ
-   * @param なし
-   * @return mode_の値
-   */
-  inline unsigned int getMode() const{
-	return mode_;
-  }
-        
-  /**
-   * @brief mode_に対するsetアクセサ
-   * @param [in] mode mode_にセットする値
-   * @return なし
-   */
-  inline void setMode(const unsigned int mode){
-	mode_ = mode;
-  }
-};
-
-/**
- * @class  Plugboard
- * @brief エニグマのプラグボード部分を実装
- */
-class Plugboard{
-private:
-  std::vector<int> plugboard; //プラグボードのキー配列
-  DISALLOW_COPY_AND_ASSIGN(Plugboard);
-public:
-  /**
-   * デフォルトコンストラクタ
-   */
-  Plugboard(){
-	for(int i = 0; i < 26; i++){
-	  plugboard.push_back(i);
-	}
-  }
-  /**
-   * コンストラクタ
-   * @param [in] キー配列を初期化する乱数の種
-   */
-  explicit Plugboard(const unsigned int seed){
-	for(int i = 0; i < 26; i++){
-	  plugboard.push_back(i);
-	}
-	srand(seed);
-	std::random_shuffle(plugboard.begin(), plugboard.end());
-  }
-        
-  /**
-   * @brief 暗号化を行う(行き)
-   * @param [in] code アルファベットのID
-   * @return 換字されたアルファベットのID
-   */
-  inline const int GoingEncipher(const int code){
-	int code_ = plugboard[code];
-	return code_;
-  }
-        
-  /**
-   * @brief 暗号化を行う(帰り)
-   * @param [in] code アルファベットのID
-   * @return 換字されたアルファベットのID
-   */
-  int ReturningEncipher(const int code) const{
-	int code_ = 0;
-	for(unsigned int i=0; i<plugboard.size(); i++){
-	  if(plugboard[i] == code){
-		code_ = i;
-		break;
-	  }
-	}
-	return code_;
-  }
-        
-  /**
-   * @brief 暗号化と変換経過の表示を行う(行き)
-   * @param [in] code アルファベットのID
-   * @return 換字されたアルファベットのID
-   */
-  inline int VisibleGoingEncipher(const int code) const{
-	int code_ = code;
-	std::map<int, char> alphaIDmap = AlphaID2Alpha();
-	std::cout << "\t  " << alphaIDmap[code_] << " --> ";
-	code_ = plugboard[code_];
-	std::cout << alphaIDmap[code_] << " --> ";
-	return code_;
-  }
-        
-  /**
-   * @brief 暗号化と変換経過の表示を行う(帰り)
-   * @param [in] code アルファベットのID
-   * @return 換字されたアルファベットのID
-   */
-  int VisibleReturningEncipher(const int code) const{
-	std::map<int, char> alphaIDmap = AlphaID2Alpha();
-	int code_ = 0;
-	for(unsigned int i=0; i<plugboard.size(); i++){
-	  if(plugboard[i] == code){
-		code_ = i;
-		break;
-	  }
-	}
-	std::cout << alphaIDmap[code_] << std::endl;
-	return code_;
-  }
-        
-  /**
-   * @brief キー配列を表示する
-   * @param なし
-   * @return なし
-   */
-  void ShowKeyArray() const{
-	int tmp;
-	std::map<int, char> alphaIDmap = AlphaID2Alpha();
-	std::cout << "\t  Plugboard [ " ;
-	for(unsigned int i=0; i<plugboard.size(); i++){
-	  tmp = plugboard[i];
-	  std::cout << alphaIDmap[tmp] << " ";
-	}
-	std::cout << "]" << std::endl;
-  }
-};
-
-/**
- * @class Scrambler
- * @brief エニグマのスクランブラー（歯車）を実装
- */
-class Scrambler{
-private:
-  DISALLOW_COPY_AND_ASSIGN(Scrambler);
-protected:
-  std::vector<int> rotor; //スクランブラーのキー配列
-public:
-  /**
-   * デフォルトコンストラクタ
-   */
-  Scrambler(){
-	for(int i = 0; i < 26; i++){
-	  rotor.push_back(i);
-	}
-  }
-        
-  /**
-   * コンストラクタ
-   * @param [in] キー配列を初期化する乱数の種
-   */
-  explicit Scrambler(const unsigned int seed){
-	for(int i = 0; i < 26; i++){
-	  rotor.push_back(i);
-	}
-	srand(seed);
-	std::random_shuffle(rotor.begin(), rotor.end());
-  }
-        
-  /**
-   * デストラクタ
-   */
-  virtual ~Scrambler(){
-  }
-        
-  /**
-   * @brief 指定の位置にスクランブラーのキーを合わせる
-   * @param [in] key 合わせるキー
-   * @return なし
-   */
-  void Set(const int key){
-	while(rotor[0] != key){
-	  rotor.insert(rotor.begin(), rotor.back());
-	  rotor.pop_back();
-	}
-  }
-        
-  /**
-   * @brief キーを１つずらす
-   * @param なし
-   * @return なし
-   */
-  virtual void ChangeKey(){
-	//末尾の要素を先頭にinsertした後pop_back
-	rotor.insert(rotor.begin(), rotor.back());
-	rotor.pop_back();
-  }
-        
-  /**
-   * @brief 暗号化を行う(行き)
-   * @param [in] code アルファベットのID
-   * @return 換字されたアルファベットのID
-   */
-  inline int GoingEncipher(const int code) const{
-	return rotor[code];
-  }
-        
-  /**
-   * @brief 暗号化を行う(帰り)
-   * @param [in] code アルファベットのID
-   * @return 換字されたアルファベットのID
-   */
-  int ReturningEncipher(const int code) const{
-	int temp;
-	for(unsigned int i=0; i<rotor.size(); i++){
-	  if(rotor[i] == code){
-		temp = i;
-		break;
-	  }
-	}
-	return temp;
-  }
-        
-  /**
-   * @brief 暗号化と変換の経過表示を行う(行き)
-   * @param [in] code アルファベットのID
-   * @return 換字されたアルファベットのID
-   */
-  inline int VisibleGoingEncipher(const int code) const{
-	int code_ = rotor[code];
-	std::map<int, char> alphaIDmap = AlphaID2Alpha();
-	std::cout << alphaIDmap[code_] << " --> ";
-	return code_;
-  }
-        
-  /**
-   * @brief 暗号化と変換の経過表示を行う(帰り)
-   * @param [in] code アルファベットのID
-   * @return 換字されたアルファベットのID
-   */
-  int VisibleReturningEncipher(const int code) const{
-	int code_ = 0;
-	std::map<int, char> alphaIDmap = AlphaID2Alpha();
-	for(unsigned int i=0; i<rotor.size(); i++){
-	  if(rotor[i] == code){
-		code_ = i;
-		break;
-	  }
-	}
-	std::cout << alphaIDmap[code_] << " --> ";
-	return code_;
-  }
-        
-  /**
-   * @brief キー配列を表示する
-   * @param なし
-   * @return なし
-   */
-  void ShowKeyArray() const{
-	int tmp;
-	std::map<int, char> alphaIDmap = AlphaID2Alpha();
-	std::cout << "[ " ;
-	for(unsigned int i=0; i<rotor.size(); i++){
-	  tmp = rotor[i];
-	  std::cout << alphaIDmap[tmp] << " ";
-	}
-	std::cout << "]" << std::endl;
-  }
-};
-
-/**
- * @class LatchingScrambler
- * @brief 次のスクランブラーを１目盛り回転させる機能を持ったスクランブラーを実装
- */
-class LatchingScrambler : public Scrambler{
-private:
-  int cnt = 0;    //自分が回った回数をカウントするための変数
-  Scrambler *nextRing = NULL; //自分が一周したときに回すスクランブラーの参照
-  DISALLOW_COPY_AND_ASSIGN(LatchingScrambler);
-public:
-  /**
-   * デフォルトコンストラクタ
-   */
-  LatchingScrambler(){
-	cnt = 0;
-  }
-  /**
-   * コンストラクタ
-   * @param [in] 自分の次のリングの参照
-   * @param [in] キー配列を初期化する乱数の種
-   */
-  LatchingScrambler(Scrambler *nextScrambler, const unsigned int seed) : Scrambler(seed){
-	cnt = 0;
-	nextRing = nextScrambler;
-  }
-        
-  /**
-   * @brief キーを１つずらす
-   * @param なし
-   * @return なし
-   */
-  void ChangeKey(){
-	//末尾の要素を先頭にinsertした後pop_backしカウントを増やす
-	rotor.insert(rotor.begin(), rotor.back());
-	rotor.pop_back();
-	AddCnt();
-  }
-        
-  /**
-   * @brief 自身がどれだけ回ったかカウントする
-   * @param なし
-   * @return なし
-   */
-  void AddCnt(){
-	cnt++;
-	if(cnt == 26){
-	  AddNextCnt();
-	  cnt = 0;
-	}
-  }
-        
-  /**
-   * @brief 自分が1回転したら次のスクランブラーのキーを１目盛り回す
-   * @param なし
-   * @return なし
-   */
-  void AddNextCnt(){
-	nextRing->ChangeKey();
-  }
-};
-
-/**
- * @class Reflector
- * @brief エニグマのリフレクターを実装
- */
-class Reflector{
-private:
-  std::vector<int> reflector; //リフレクターのキー配列
-  DISALLOW_COPY_AND_ASSIGN(Reflector);
-public:
-  /**
-   * デフォルトコンストラクタ
-   */
-  Reflector(){
-	for(int i = 0; i < 26; i++){
-	  reflector.push_back(i);
-	}
-	for(int i = 0; i < 13; i++){
-	  std::swap(reflector[i], reflector[25 - i]);
-	}
-  }
-  /**
-   * コンストラクタ
-   * @param [in] キー配列を初期化する乱数の種
-   * @detail 例えば入力Aが出力Bに変換されるなら,入力Bは出力Aに変換されるように初期化
-   */
-  explicit Reflector(const unsigned int seed){
-	for(int i = 0; i < 26; i++){
-	  reflector.push_back(i);
-	}
-	std::vector<int> ref_copy = reflector;
-	srand(seed);
-	random_shuffle(ref_copy.begin(), ref_copy.end());
-	for(int i=0; i < 13; i++){
-	  //swapで入出力の対応関係を保った初期化を行う
-	  std::swap(reflector[(ref_copy[i])], reflector[(ref_copy[25-i])]);
-	}
-  }
-        
-  /**
-   * @brief 暗号化を行う
-   * @param [in] code アルファベットのID
-   * @return 換字されたアルファベットのID
-   */
-  inline int Reflect(const int code) const{
-	return reflector[code];
-  }
-        
-  /**
-   * @brief 暗号化と変換経過の表示を行う
-   * @param [in] code アルファベットのID
-   * @return 換字されたアルファベットのID
-   */
-  inline int VisibleReflect(const int code) const{
-	int code_ = reflector[code];
-	std::map<int, char> alphaIDmap = AlphaID2Alpha();
-	std::cout << alphaIDmap[code_] << " --> ";
-	return code_;
-  }
-        
-  /**
-   * @brief キー配列を表示する
-   * @param なし
-   * @return なし
-   */
-  void ShowKeyArray() const{
-	int tmp;
-	std::map<int, char> alphaIDmap = AlphaID2Alpha();
-	std::cout << "\t  Reflector [ " ;
-	for(unsigned int i=0; i<reflector.size(); i++){
-	  tmp = reflector[i];
-	  std::cout << alphaIDmap[tmp] << " ";
-	}
-	std::cout << "]" << std::endl;
-  }
-        
-};
-
-/**
- * @class RingSet
- * @brief スクランブラーを統括する
- */
-class RingSet{
-private:
-  Scrambler *ring3 = NULL;
-  Scrambler *ring2 = NULL;
-  Scrambler *ring1 = NULL;
-  DISALLOW_COPY_AND_ASSIGN(RingSet);
-public:
-  /**
-   * デフォルトコンストラクタ
-   */
-  RingSet(){
-	ring3 = new Scrambler(30);
-	ring2 = new LatchingScrambler(ring3,20);
-	ring1 = new LatchingScrambler(ring2,10);
-  }
-        
-  /**
-   * デストラクタ
-   */
-  ~RingSet(){
-	delete ring3;
-	delete ring2;
-	delete ring1;
-  }
-        
-  /**
-   * @brief それぞれのリングのキーを合わせる
-   * @param [in] keyset それぞれのリングのキーのID
-   * @return なし
-   */
-  void KeySet(const std::vector<int> keyset){
-	ring1->Set(keyset[0]);
-	ring2->Set(keyset[1]);
-	ring3->Set(keyset[2]);
-  }
-        
-  /**
-   * @brief ring1のキーの配置を変える
-   * @param なし
-   * @return なし
-   */
-  void EndCycle(){
-	ring1->ChangeKey();
-  }
-        
-  /**
-   * @brief 暗号化を行う(行き)
-   * @param [in] code アルファベットのID
-   * @return 換字されたアルファベットのID
-   */
-  inline int GoingEncipher(const int code) const{
-	int code_ = code;
-	code_ = ring1->GoingEncipher(code_);
-	code_ = ring2->GoingEncipher(code_);
-	code_ = ring3->GoingEncipher(code_);
-	return code_;
-  }
-
-  /**
-   * @brief 暗号化を行う(帰り)
-   * @param [in] code アルファベットのID
-   * @return 換字されたアルファベットのID
-   */
-  inline int ReturningEncipher(const int code) const{
-	int code_ = code;
-	code_ = ring3->ReturningEncipher(code_);
-	code_ = ring2->ReturningEncipher(code_);
-	code_ = ring1->ReturningEncipher(code_);
-	return code_;
-  }
-        
-  /**
-   * @brief 暗号化と変換の経過表示を行う(行き)
-   * @param [in] code アルファベットのID
-   * @return 換字されたアルファベットのID
-   */
-  inline int VisibleGoingEncipher(const int code) const{
-	int code_ = code;
-	code_ = ring1->VisibleGoingEncipher(code_);
-	code_ = ring2->VisibleGoingEncipher(code_);
-	code_ = ring3->VisibleGoingEncipher(code_);
-	return code_;
-  }
-
-  /**
-   * @brief 暗号化と変換の経過表示を行う(帰り)
-   * @param [in] code アルファベットのID
-   * @return 換字されたアルファベットのID
-   */
-  inline int VisibleReturningEncipher(const int code) const{
-	int code_ = code;
-	code_ = ring3->VisibleReturningEncipher(code_);
-	code_ = ring2->VisibleReturningEncipher(code_);
-	code_ = ring1->VisibleReturningEncipher(code_);
-	return code_;
-  }
-        
-  /**
-   * @brief キー配列を表示する
-   * @param なし
-   * @return なし
-   */
-  void ShowKeyArray() const{
-	std::cout << "\t  Ring1     ";
-	ring1->ShowKeyArray();
-	std::cout << "\t  Ring2     ";
-	ring2->ShowKeyArray();
-	std::cout << "\t  Ring3     ";
-	ring3->ShowKeyArray();
-  }
-};
-
-/**
- * @class Enigma
- * @brief プログラムの中枢を実装
+ * プロトタイプ宣言
  */
-class Enigma{
-private:
-  Plugboard *plugboard = NULL;
-  RingSet *ringSet = NULL;
-  Reflector *reflector = NULL;
-  DISALLOW_COPY_AND_ASSIGN(Enigma);
-public:
-  /**
-   * デフォルトコンストラクタ
-   */
-  Enigma(){
-	plugboard = new Plugboard(100);
-	ringSet = new RingSet();
-	reflector = new Reflector(200);
-  }
-        
-  /**
-   * デストラクタ
-   */
-  ~Enigma(){
-	delete plugboard;
-	delete ringSet;
-	delete reflector;
-  }
-        
-  /**
-   * それぞれのリングにキーを設定する
-   * @param [in] key キーが大文字アルファベット3文字で与えられる
-   * @return なし
-   */
-  void KeySet(const std::string key){
-	std::map<char, int> alphamap = Alpha2AlphaID();
-	/*keyを対応表に則ってint型に変更する*/
-	std::vector<int> key_temp;
-	for(unsigned int i = 0; i<key.length(); i++){
-	  key_temp.push_back(alphamap[(key[i])]);
-	}
-	/*リングセットクラスのセット関数を呼び出してキーをセットする*/
-	ringSet->KeySet(key_temp);
-  }
-        
-  /**
-   * 暗号化(複号化)を行う
-   * @param [in] code この入力に対してEnigmaを実行する
-   * @return Enigmaによる変換後の文字列
-   */
-  std::string Encryption(const std::string code) const{
-	std::map<char, int> alphamap = Alpha2AlphaID();
-	std::map<int, char> alphaIDmap = AlphaID2Alpha();
-	std::string cryptogram = "";
-            
-	/*keyを対応表に則ってint型に変更する*/
-	std::vector<int> code_temp;
-	for(unsigned int i = 0; i<code.length(); i++){
-	  code_temp.push_back(alphamap[(code[i])]);
-	}
-
-	/*一文字ずつ暗号化（複号化）を行う*/
-	int temp = 0;
-	for(unsigned int i=0; i<code_temp.size(); i++){
-	  temp = code_temp[i];
-	  temp = plugboard->GoingEncipher(temp);
-	  temp = ringSet->GoingEncipher(temp);
-	  temp = reflector->Reflect(temp);
-	  temp = ringSet->ReturningEncipher(temp);
-	  temp = plugboard->ReturningEncipher(temp);
-                
-	  cryptogram += alphaIDmap[temp];
-	  ringSet->EndCycle();
-	}
-	return cryptogram;
-  }
-        
-  /**
-   * 暗号化(複号化)と変換経過の表示を行う
-   * @param [in] code この入力に対してEnigmaを実行する
-   * @return Enigmaによる変換後の文字列
-   */
-  std::string VisibleEncryption(const std::string code) const{
-	std::map<char, int> alphamap = Alpha2AlphaID();
-	std::map<int, char> alphaIDmap = AlphaID2Alpha();
-	std::string cryptogram = "";
-            
-	/*keyを対応表に則ってint型に変更する*/
-	std::vector<int> code_temp;
-	for(unsigned int i = 0; i<code.length(); i++){
-	  code_temp.push_back(alphamap[(code[i])]);
-	}
-
-	/*一文字ずつ暗号化（複号化）と変換経過の表示を行う*/
-	std::cout << "\tCode Conversion Process\n";
-	std::cout << "\t    Plg   Ri1   Ri2   Ri3   Ref   Ri3   Ri2   Ri1   Plg\n";
-	int temp = 0;
-	for(unsigned int i=0; i<code_temp.size(); i++){
-	  temp = code_temp[i];
-	  temp = plugboard->VisibleGoingEncipher(temp);
-	  temp = ringSet->VisibleGoingEncipher(temp);
-	  temp = reflector->VisibleReflect(temp);
-	  temp = ringSet->VisibleReturningEncipher(temp);
-	  temp = plugboard->VisibleReturningEncipher(temp);
-                
-	  cryptogram += alphaIDmap[temp];
-	  ringSet->EndCycle();
-	}
-	std::cout << std::endl;
-	return cryptogram;
-  }
-        
-  /**
-   * 暗号化(複号化)と毎回のキー配列・変換経過の表示を行う
-   * @param [in] code この入力に対してEnigmaを実行する
-   * @return Enigmaによる変換後の文字列
-   */
-  std::string KeyVisibleEncryption(const std::string code) const{
-	std::map<char, int> alphamap = Alpha2AlphaID();
-	std::map<int, char> alphaIDmap = AlphaID2Alpha();
-	std::string cryptogram = "";
-            
-	/*keyを対応表に則ってint型に変更する*/
-	std::vector<int> code_temp;
-	for(unsigned int i = 0; i<code.length(); i++){
-	  code_temp.push_back(alphamap[(code[i])]);
-	}
-
-	/*一文字ずつ暗号化（複号化）を行い、サイクル毎にキー配列を表示*/
-	int temp = 0;
-	for(unsigned int i=0; i<code_temp.size(); i++){
-	  std::cout << "\tKey Array : " << (i+1) << "cycle\n";
-	  ShowKeyArray();
-	  std::cout << "\n";
-	  std::cout << "\tCode Conversion Process\n";
-	  std::cout << "\t    Plg   Ri1   Ri2   Ri3   Ref   Ri3   Ri2   Ri1   Plg\n";
-	  temp = code_temp[i];
-	  //std::cout << "\t  " << alphaIDmap[temp] << " --> ";
-	  temp = plugboard->VisibleGoingEncipher(temp);
-	  temp = ringSet->VisibleGoingEncipher(temp);
-	  temp = reflector->VisibleReflect(temp);
-	  temp = ringSet->VisibleReturningEncipher(temp);
-	  temp = plugboard->VisibleReturningEncipher(temp);
-                
-	  cryptogram += alphaIDmap[temp];
-	  ringSet->EndCycle();
-	  std::cout << "\n";
-	}
-	std::cout << std::endl;
-	return cryptogram;
-  }
-        
-  /**
-   * @brief キー配列を表示する
-   * @param なし
-   * @return なし
-   */
-  void ShowKeyArray() const{
-	std::cout << "\t            [ A B C D E F G H I J K L M N O P Q R S T U V W X Y Z ]" << std::endl;
-	std::cout << "\t              | | | | | | | | | | | | | | | | | | | | | | | | | |  " << std::endl;
-	plugboard->ShowKeyArray();
-	ringSet->ShowKeyArray();
-	reflector->ShowKeyArray();
-  }
-        
-  /**
-   * モードに応じた処理を実行する
-   * @param [in] arguments 引数情報を格納しているオブジェクト
-   * @return Enigmaによる変換後の文字列
-   */
-  std::string Execute(const Arguments &arguments) const{
-	std::string code = arguments.getCode();
-	unsigned int mode = arguments.getMode();
-	if(mode & OUT_FILE_MODE){
-	  std::ofstream ofs(arguments.getOutFileName());
-	  std::string cryptogram = Encryption(code);
-	  ofs << cryptogram << std::endl;
-	  return "";
-	}
-	if(mode & SHOW_DEFAULT_KEY_ARRAY_MODE){
-	  std::cout << "\tDefault Key Array\n";
-	  ShowKeyArray();
-	  std::cout << std::endl;
-	}
-	if(mode & SHOW_KEY_ARRAY_MODE){
-	  return KeyVisibleEncryption(code);    
-	}else if(mode & SHOW_TRANSITION_MODE){
-	  return VisibleEncryption(code);
-	}else{
-	  return Encryption(code);
-	}
-  }
-};
+int GetOption(int argc, char *argv[], Arguments &arguments);
 
 /**
  * プロトタイプ宣言
  */
-int GetOption(int argc, char *argv[], Arguments &arguments);
+template<int N>
+int EnigmaExecute(BasicEnigma<N> enigma, const Arguments &arguments);
 
 /**
  * @brief プログラムのエントリポイント
@@ -869,8 +47,7 @@ int GetOption(int argc, char *argv[], Arguments &arguments);
 int main(int argc, char *argv[]){
   /*変数宣言*/
   Arguments arguments; //引数を格納するためのオブジェクト
-  std::string cryptogram = "";  //暗号文（平文）を格納するための変数
-  Enigma *enigma = new Enigma();  //エニグマのオブジェクト
+  Enigma enigma;  //エニグマのオブジェクト(起動時にヒープ領域を確保しないようスタックに置く)
     
   /*引数がなかったときの処理*/
   if(argc == 1){
@@ -881,18 +58,95 @@ int main(int argc, char *argv[]){
   }
     
   /*オプションの解析*/
-  if((GetOption(argc, argv, arguments)) < 0){
-	std::cerr << "\tProgram stopped." << std::endl;
-	return -1;
-  };
+  {
+	ENIGMA_STAGE(STAGE_PARSE);
+	if((GetOption(argc, argv, arguments)) < 0){
+	  std::cerr << "\tProgram stopped." << std::endl;
+	  return -1;
+	};
+  }
+    
+  /*--statsが指定された場合は終了時に計測結果を書き出す*/
+  if(arguments.getMode() & STATS_MODE){
+	EnableStats(arguments.getMode() & CYCLE_STATS_MODE);
+  }
+    
+  /*n-gram作成モードでは英文からn-gramのバイナリファイルを作る*/
+  if(arguments.getMode() & NGRAM_BUILD_MODE){
+	return (NgramModel::Build(arguments.getCorpus(), arguments.getNgramFile()) < 0) ? -1 : 0;
+  }
+    
+  /*プラグボードが指定された場合はその配線にする*/
+  if(!arguments.getPlugboard().empty()){
+	Plugboard plugboard;
+	ParsePlugboard(arguments.getPlugboard(), plugboard);
+	enigma = Enigma(EnigmaConfig(plugboard));
+  }
+    
+  /*キー探索モードでは暗号文からキーの候補を探す*/
+  if(arguments.getMode() & ATTACK_MODE){
+	if(arguments.getProcesses() > 0){
+	  return (ShardExecute(enigma.getConfig(), arguments) < 0) ? -1 : 0;
+	}
+	return (AttackExecute(enigma.getConfig(), arguments) < 0) ? -1 : 0;
+  }
+    
+  /*既知平文攻撃モードではクリブと一致するキーと位置を探す*/
+  if(arguments.getMode() & CRIB_MODE){
+	return (CribExecute(enigma.getConfig(), arguments) < 0) ? -1 : 0;
+  }
+    
+  /*プラグボード探索モードではキーを固定してプラグボードを探す*/
+  if(arguments.getMode() & PLUGBOARD_SEARCH_MODE){
+	return (PlugboardExecute(enigma.getConfig(), arguments) < 0) ? -1 : 0;
+  }
+    
+  /*キーの文字数と同じ枚数のリングを持つエニグマで実行する*/
+  switch(arguments.getKey().length()){
+  case 4:
+	return EnigmaExecute(BasicEnigma<4>(BasicEnigmaConfig<4>(enigma.getConfig().getPlugboard())), arguments);
+  case 5:
+	return EnigmaExecute(BasicEnigma<5>(BasicEnigmaConfig<5>(enigma.getConfig().getPlugboard())), arguments);
+  default:
+	return EnigmaExecute(enigma, arguments);
+  }
+}
+
+/**
+ * @brief キーと位置を合わせ,モードに応じて暗号化(複号化)して結果を出力する
+ * @tparam N リングの枚数(キーの文字数)
+ * @param [in] enigma 配線を合わせたエニグマ(スタックに置いたものを複製して使う)
+ * @param [in] arguments 引数情報を格納しているオブジェクト
+ * @return 終了ステータス
+ */
+template<int N>
+int EnigmaExecute(BasicEnigma<N> enigma, const Arguments &arguments){
+  std::string cryptogram = "";  //暗号文（平文）を格納するための変数
     
   /*エニグマのキーをセット*/
-  enigma->KeySet(arguments.getKey());
+  enigma.KeySet(arguments.getKey());
+  enigma.Seek(arguments.getOffset());
     
-  /*エニグマの実行*/
-  cryptogram = enigma->Execute(arguments);
+  /*フィルタモードでは結果だけを標準出力に書き出す*/
+  if(arguments.getMode() & FILTER_MODE){
+	return (enigma.FilterExecute(STDIN_FILENO, STDOUT_FILENO) < 0) ? -1 : 0;
+  }
+    
+  /*バッチモードではジョブファイルの結果だけを1行ずつ書き出す*/
+  if(arguments.getMode() & BATCH_JOB_MODE){
+	std::ios::sync_with_stdio(false); //標準入出力を使う場合に行単位の読み書きを速くする
+	return (enigma.BatchJobExecute(arguments) < 0) ? -1 : 0;
+  }
+    
+  /*エニグマの実行(ファイルからファイルへの変換はブロックごとに逐次処理し,変換経過もブロックごとに表示・記録する)*/
+  if(enigma.Execute(arguments, cryptogram) < 0){
+	std::cerr << "\tProgram stopped." << std::endl;
+	return -1;
+  }
     
   /*結果出力*/
+  ENIGMA_STAGE(STAGE_WRITE);
+  ENIGMA_COUNT(COUNTER_BYTES_WRITTEN, cryptogram.length());
   std::cout << "\tArgument Information\n";
   if(arguments.getMode() & READ_FILE_MODE){
 	std::cout << "\t  -Argument File -> " << arguments.getInFileName() << "\n";
@@ -907,41 +161,10 @@ int main(int argc, char *argv[]){
 	std::cout << "\t  -Encrypted String -> " << cryptogram << std::endl;
   }
     
-  delete enigma;
   return 0;
 }
 
 
-/**
- * @brief アルファベットを数字に対応付けるmapを生成する関数
- * @param なし
- * @return アルファベット->数字の対応表
- */
-std::map<char, int> Alpha2AlphaID(){
-  std::map<char, int> alphaTable;
-  const std::string ALPHA = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-  for(unsigned int i=0; i<ALPHA.length(); i++){
-	alphaTable[ALPHA[i]] = i;
-  }
-  return alphaTable;
-}
-
-
-/**
- * @brief 数字をアルファベットに対応付けるmapを生成する関数
- * @param なし
- * @return 数字->アルファベットの対応表
- */
-std::map<int, char> AlphaID2Alpha(){
-  std::map<int, char> alphaTable;
-  const std::string ALPHA = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-  for(unsigned int i=0; i<ALPHA.length(); i++){
-	alphaTable[i] = ALPHA[i];
-  }
-  return alphaTable;
-}
-
-
 /**
  * @brief オプションを解析する関数
  * @param [in] argc コマンドライン引数の数
@@ -950,22 +173,45 @@ std::map<int, char> AlphaID2Alpha(){
  * @return 終了ステータス
  */
 int GetOption(int argc, char *argv[], Arguments &arguments){
+  static const int STATS_OPTION = 256; //--statsに割り当てる(1文字のオプションと重ならない)値
+  static const struct option long_options[] = {
+	{"stats", optional_argument, NULL, STATS_OPTION},
+	{NULL, 0, NULL, 0}
+  };
   int ch = 0;
   std::string key = arguments.getKey();
   std::string code = arguments.getCode();
   std::string in_file_name = arguments.getInFileName();
   std::string out_file_name = arguments.getOutFileName();
   unsigned int mode = arguments.getMode();
+  unsigned long long offset = arguments.getOffset();
+  unsigned int jobs = arguments.getJobs();
+  bool jobs_given = false; //-jでスレッド数を指定したか
+  unsigned int candidates = arguments.getCandidates();
+  double threshold = arguments.getThreshold();
+  unsigned int score = arguments.getScore();
+  std::string crib = arguments.getCrib();
+  std::string plugboard = arguments.getPlugboard();
+  std::string corpus = arguments.getCorpus();
+  double budget = arguments.getBudget();
+  std::string ngram_file = arguments.getNgramFile();
+  std::string checkpoint = arguments.getCheckpoint();
+  double interval = arguments.getInterval();
+  unsigned int processes = arguments.getProcesses();
+  std::string trace_file = arguments.getTraceFile();
+  unsigned long long trace_from = arguments.getTraceFrom();
+  unsigned long long trace_to = arguments.getTraceTo();
+  unsigned long long trace_every = arguments.getTraceEvery();
     
   /*オプションを解析*/
-  while((ch = getopt(argc, argv, "s:htdkf:o:")) != -1){
+  while((ch = getopt_long(argc, argv, "s:htdkf:o:pvn:j:rb:ac:e:g:w:P:ql:x:m:C:i:N:T:R:E:", long_options, NULL)) != -1){
 	switch(ch){
 	case 's':   //スクランブラーをセット
 	  key = optarg;
 	  transform(key.begin(), key.end(), key.begin(), ToUpper());
-	  /*キーがアルファベット３文字でない場合エラー処理*/
-	  if((any_of(key.begin(), key.end(), IsDigit())) || key.length() != 3){
-		std::cerr << "\t\"" << key << "\" is invalid key! Input three characters like \"AAA\"" << std::endl;
+	  /*キーがアルファベット3~5文字(リングの枚数)でない場合エラー処理*/
+	  if((any_of(key.begin(), key.end(), IsDigit())) || key.length() < MIN_ROTORS || key.length() > MAX_ROTORS){
+		std::cerr << "\t\"" << key << "\" is invalid key! Input three to five characters like \"AAA\" or \"AAAAA\"" << std::endl;
 		return -1;
 	  }
 	  break;
@@ -989,6 +235,169 @@ int GetOption(int argc, char *argv[], Arguments &arguments){
 	  mode |= OUT_FILE_MODE;
 	  out_file_name = optarg;
 	  break;
+	case 'p':
+	  mode |= PERIOD_TABLE_MODE;
+	  break;
+	case 'v':
+	  mode |= BATCH_KERNEL_MODE;
+	  break;
+	case 'r':
+	  mode |= FILTER_MODE;
+	  break;
+	case 'b':   //ジョブファイルをセット("-"なら標準入力)
+	  mode |= BATCH_JOB_MODE;
+	  in_file_name = optarg;
+	  break;
+	case 'a':
+	  mode |= ATTACK_MODE;
+	  break;
+	case 'c':   //キーの候補の数をセット
+	  /*候補の数が正の数でない場合エラー処理*/
+	  if(*optarg == '\0' || !std::all_of(optarg, optarg + strlen(optarg), IsDigit()) || atoi(optarg) <= 0){
+		std::cerr << "\t\"" << optarg << "\" is invalid number of candidates! Input a positive number like \"5\"" << std::endl;
+		return -1;
+	  }
+	  candidates = atoi(optarg);
+	  break;
+	case 'e':   //探索を打ち切る点数をセット
+	  {
+		char *end = NULL;
+		threshold = strtod(optarg, &end);
+		if(*optarg == '\0' || *end != '\0'){
+		  std::cerr << "\t\"" << optarg << "\" is invalid threshold! Input a number like \"0.06\"" << std::endl;
+		  return -1;
+		}
+	  }
+	  break;
+	case 'g':   //探索の採点方法をセット
+	  if(strcmp(optarg, "ioc") == 0){
+		score = SCORE_IOC;
+	  }else if(strcmp(optarg, "mono") == 0){
+		score = SCORE_MONOGRAM;
+	  }else{
+		std::cerr << "\t\"" << optarg << "\" is invalid scoring! Input \"ioc\" or \"mono\"" << std::endl;
+		return -1;
+	  }
+	  break;
+	case 'w':   //クリブをセット
+	  mode |= CRIB_MODE;
+	  /*クリブがアルファベットでない場合エラー処理*/
+	  if(!NormalizeBlock(optarg, strlen(optarg), crib) || crib.empty()
+		 || !std::all_of(crib.begin(), crib.end(), isupper)){
+		std::cerr << "\t\"" << optarg << "\" is invalid crib! Input letters like \"WETTERBERICHT\"" << std::endl;
+		return -1;
+	  }
+	  break;
+	case 'P':   //プラグボードをセット
+	  plugboard = optarg;
+	  transform(plugboard.begin(), plugboard.end(), plugboard.begin(), ToUpper());
+	  /*プラグボードがアルファベット26文字の並べ替えでない場合エラー処理*/
+	  {
+		Plugboard temp;
+		if(!ParsePlugboard(plugboard, temp)){
+		  std::cerr << "\t\"" << optarg << "\" is invalid plugboard! Input each of 26 letters once like \"BADCFE...\"" << std::endl;
+		  return -1;
+		}
+	  }
+	  break;
+	case 'q':
+	  mode |= PLUGBOARD_SEARCH_MODE;
+	  break;
+	case 'l':   //n-gramを数える英文のファイルをセット
+	  corpus = optarg;
+	  break;
+	case 'm':   //書き出すn-gramのバイナリファイルをセット
+	  mode |= NGRAM_BUILD_MODE;
+	  ngram_file = optarg;
+	  break;
+	case 'x':   //プラグボードの探索に使う秒数をセット
+	  {
+		char *end = NULL;
+		budget = strtod(optarg, &end);
+		if(*optarg == '\0' || *end != '\0' || budget <= 0.0){
+		  std::cerr << "\t\"" << optarg << "\" is invalid time budget! Input seconds like \"10\"" << std::endl;
+		  return -1;
+		}
+	  }
+	  break;
+	case 'C':   //チェックポイントのファイルをセット
+	  checkpoint = optarg;
+	  break;
+	case 'i':   //チェックポイントを書き出す間隔をセット
+	  {
+		char *end = NULL;
+		interval = strtod(optarg, &end);
+		if(*optarg == '\0' || *end != '\0' || interval < 0.0){
+		  std::cerr << "\t\"" << optarg << "\" is invalid checkpoint interval! Input seconds like \"60\"" << std::endl;
+		  return -1;
+		}
+	  }
+	  break;
+	case 'N':   //キーの探索に用いるワーカープロセス数をセット
+	  /*プロセス数が正の数でない場合エラー処理*/
+	  if(*optarg == '\0' || !std::all_of(optarg, optarg + strlen(optarg), IsDigit()) || atoi(optarg) <= 0){
+		std::cerr << "\t\"" << optarg << "\" is invalid number of processes! Input a positive number like \"4\"" << std::endl;
+		return -1;
+	  }
+	  processes = atoi(optarg);
+	  break;
+	case STATS_OPTION:   //終了時に計測結果を書き出す(--stats=cyclesならCPUサイクル数も数える)
+	  mode |= STATS_MODE;
+	  if(optarg != NULL && strcmp(optarg, "cycles") == 0){
+		mode |= CYCLE_STATS_MODE;
+	  }else if(optarg != NULL){
+		std::cerr << "\t\"" << optarg << "\" is invalid stats mode! Input \"--stats\" or \"--stats=cycles\"" << std::endl;
+		return -1;
+	  }
+	  break;
+	case 'T':   //変換経過を記録するバイナリトレースのファイルをセット
+	  mode |= TRACE_FILE_MODE;
+	  trace_file = optarg;
+	  break;
+	case 'R':   //変換経過を記録・表示する範囲をセット("FROM:TO",TOは省略できる)
+	  {
+		char *end = NULL;
+		errno = 0;
+		trace_from = strtoull(optarg, &end, 10);
+		bool valid = isdigit(*optarg) && *end == ':' && errno != ERANGE;
+		if(valid && end[1] != '\0'){
+		  char *to_end = NULL;
+		  trace_to = strtoull(end + 1, &to_end, 10);
+		  valid = isdigit(end[1]) && *to_end == '\0' && errno != ERANGE && trace_to > trace_from;
+		}
+		if(!valid){
+		  std::cerr << "\t\"" << optarg << "\" is invalid trace range! Input positions like \"1000:2000\" or \"1000:\"" << std::endl;
+		  return -1;
+		}
+	  }
+	  break;
+	case 'E':   //変換経過を記録・表示する間隔をセット
+	  /*間隔が正の数でない(大きすぎる)場合エラー処理*/
+	  errno = 0;
+	  trace_every = strtoull(optarg, NULL, 10);
+	  if(*optarg == '\0' || !std::all_of(optarg, optarg + strlen(optarg), IsDigit()) || errno == ERANGE
+		 || trace_every == 0){
+		std::cerr << "\t\"" << optarg << "\" is invalid trace interval! Input a positive number like \"100\"" << std::endl;
+		return -1;
+	  }
+	  break;
+	case 'n':   //暗号化を始める位置をセット
+	  /*位置が数字でない場合エラー処理*/
+	  if(*optarg == '\0' || !std::all_of(optarg, optarg + strlen(optarg), IsDigit())){
+		std::cerr << "\t\"" << optarg << "\" is invalid offset! Input a non-negative number like \"1000\"" << std::endl;
+		return -1;
+	  }
+	  offset = strtoull(optarg, NULL, 10);
+	  break;
+	case 'j':   //スレッド数をセット
+	  /*スレッド数が正の数でない場合エラー処理*/
+	  if(*optarg == '\0' || !std::all_of(optarg, optarg + strlen(optarg), IsDigit()) || atoi(optarg) <= 0){
+		std::cerr << "\t\"" << optarg << "\" is invalid number of threads! Input a positive number like \"4\"" << std::endl;
+		return -1;
+	  }
+	  jobs = atoi(optarg);
+	  jobs_given = true;
+	  break;
 	default:
 	  std::cerr << "\tInvalid option was riquired!" << std::endl;
 	  return -1;
@@ -996,6 +405,24 @@ int GetOption(int argc, char *argv[], Arguments &arguments){
 	}
   }
     
+  /*探索モードで-jがなければすべてのコアを使う(-Nならワーカープロセスで分け合う)*/
+  if(!jobs_given && (mode & (ATTACK_MODE | CRIB_MODE | PLUGBOARD_SEARCH_MODE))){
+	unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+	jobs = std::max(1u, cores / std::max(1u, processes));
+  }
+    
+  /*範囲や間隔だけを指定した場合は変換経過(-t)を表示する*/
+  if((trace_from > 0 || trace_to != ULLONG_MAX || trace_every > 1)
+	 && !(mode & (SHOW_TRANSITION_MODE | SHOW_KEY_ARRAY_MODE | TRACE_FILE_MODE))){
+	mode |= SHOW_TRANSITION_MODE;
+  }
+    
+  /*4枚・5枚のリングでは3枚の配線を前提にしたオプションを使えない*/
+  if(key.length() != 3 && (mode & ~ROTOR_MODES)){
+	std::cerr << "\tOnly -d, -f, -o, -r, -n, -j, -P and --stats can be used with " << key.length() << " rotors!" << std::endl;
+	return -1;
+  }
+    
   /*引数を格納*/
   if(mode & READ_FILE_MODE){  //テキストファイル変換モードの時
 	std::ifstream ifs(in_file_name);
@@ -1003,12 +430,16 @@ int GetOption(int argc, char *argv[], Arguments &arguments){
 	  std::cerr << "\tFile cannot open. > " << in_file_name << std::endl;
 	  return -1;
 	}
-	std::string buf = "";
-	std::vector<std::string> split_buf;
-	while(getline(ifs, buf)){
-	  boost::algorithm::split(split_buf, buf, boost::is_any_of(" "));
-	  for(unsigned int i = 0; i<split_buf.size(); i++){
-		code += split_buf[i];
+	/*出力ファイルがある場合はEnigma::StreamExecuteで逐次読むので,ここでは読まない*/
+	if(!(mode & OUT_FILE_MODE)){
+	  std::string buf = "";
+	  std::vector<std::string> split_buf;
+	  while(getline(ifs, buf)){
+		ENIGMA_COUNT(COUNTER_BYTES_READ, buf.length() + 1);
+		boost::algorithm::split(split_buf, buf, boost::is_any_of(" "));
+		for(unsigned int i = 0; i<split_buf.size(); i++){
+		  code += split_buf[i];
+		}
 	  }
 	}
 	ifs.close();
@@ -1031,6 +462,23 @@ int GetOption(int argc, char *argv[], Arguments &arguments){
   arguments.setKey(key);
   arguments.setCode(code);
   arguments.setMode(mode);
+  arguments.setOffset(offset);
+  arguments.setJobs(jobs);
+  arguments.setCandidates(candidates);
+  arguments.setThreshold(threshold);
+  arguments.setScore(score);
+  arguments.setCrib(crib);
+  arguments.setPlugboard(plugboard);
+  arguments.setCorpus(corpus);
+  arguments.setBudget(budget);
+  arguments.setNgramFile(ngram_file);
+  arguments.setCheckpoint(checkpoint);
+  arguments.setInterval(interval);
+  arguments.setProcesses(processes);
+  arguments.setTraceFile(trace_file);
+  arguments.setTraceFrom(trace_from);
+  arguments.setTraceTo(trace_to);
+  arguments.setTraceEvery(trace_every);
   arguments.setInFileName(in_file_name);
   arguments.setOutFileName(out_file_name);
   return 0;
@@ -1047,12 +495,36 @@ int GetOption(int argc, char *argv[], Arguments &arguments){
   printf("\t  *** Arguments should be string. ***\n");
   printf("\t  attention : 1.Spaces are filled.\n");
   printf("\t              2.You can only use alphabetic characters.\n");
-  printf("\t  option -> -s : You can set Scrambler.\te.g. -s \"ABC\"\n");
+  printf("\t  option -> -s : You can set Scrambler (4 or 5 letters use 4 or 5 rotors).\te.g. -s \"ABC\"\n");
   printf("\t            -t : You can show process of conversion.\n");
   printf("\t            -d : You can show default key arrays of all parts.\n");
   printf("\t            -k : You can show transition of key arrays and process of conversion.\n");
+  printf("\t            -T : You can record the process of -t (or -k) to a binary trace file instead of showing it.\te.g. -T trace.bin\n");
+  printf("\t            -R : You can show (or record) the process of -t/-k only for the positions FROM to TO-1 of the message.\te.g. -R 1000:2000\n");
+  printf("\t            -E : You can show (or record) the process of -t/-k only for every given number of positions.\te.g. -E 100\n");
   printf("\t            -f : You can select an input text file.\n");
   printf("\t            -o : You can set an output text file.\n");
+  printf("\t            -p : You can encrypt with a precomputed full-period substitution table.\n");
+  printf("\t            -v : You can encrypt with the vectorized (SIMD) batch kernel.\n");
+  printf("\t            -n : You can start from the given character offset.\te.g. -n 1000\n");
+  printf("\t            -j : You can encrypt with the given number of threads (-a, -w and -q use all cores by default).\te.g. -j 4\n");
+  printf("\t            -r : You can use this as a filter (stdin to stdout, result only).\n");
+  printf("\t            -b : You can encrypt \"KEY MESSAGE\" lines of a job file (\"-\" for stdin).\te.g. -b jobs.txt\n");
+  printf("\t            -a : You can search the key of a ciphertext (all 17,576 keys).\n");
+  printf("\t            -c : You can set the number of key candidates to show with -a.\te.g. -c 5\n");
+  printf("\t            -e : You can stop -a when a key scores at least the threshold.\te.g. -e 0.06\n");
+  printf("\t            -g : You can select the scoring of -a (\"ioc\" or \"mono\").\te.g. -g ioc\n");
+  printf("\t            -w : You can search the keys and positions where the known plaintext (crib) fits.\te.g. -w \"WETTERBERICHT\"\n");
+  printf("\t            -P : You can set the plugboard (26 letters, the i-th letter is where the i-th letter goes).\te.g. -P \"BADCFE...\"\n");
+  printf("\t            -q : You can search the plugboard of a ciphertext for the key of -s by hill-climbing.\n");
+  printf("\t            -l : You can set an English text file or an n-gram file (made by -m) for -q.\te.g. -l corpus.txt\n");
+  printf("\t            -m : You can make an n-gram file (2 to 4 letters) from the text file of -l.\te.g. -m ngrams.bin\n");
+  printf("\t            -x : You can set the seconds to spend on -q.\te.g. -x 10\n");
+  printf("\t            -C : You can checkpoint -a and -q to a file, and resume from it if it exists.\te.g. -C search.ckpt\n");
+  printf("\t            -i : You can set the seconds between checkpoints of -C.\te.g. -i 60\n");
+  printf("\t            -N : You can split -a into shards searched by the given number of worker processes.\te.g. -N 4\n");
+  printf("\t            --stats : You can write the time and counts of each stage as JSON to stderr at exit\n");
+  printf("\t                      (\"--stats=cycles\" also counts CPU cycles). Needs a build with -DENIGMA_STATS.\n");
   printf("\t            -h : You can show help.\n");
   exit(0);
 }
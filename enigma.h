@@ -0,0 +1,2652 @@
+/**
+ * @brief エニグマ（暗号機）のシミュレータ本体
+ * @author Hirokazu Kiyomaru
+ * @attention g++ -std=c++11 としてコンパイル
+ * @date 2015/07/04
+ * @file enigma.h
+ */
+#ifndef ENIGMA_H
+#define ENIGMA_H
+
+//C++の標準ライブラリ
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <list>
+#include <random>
+#include <algorithm>
+#include <cctype>
+#include <memory>
+#include <type_traits>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <cstdio>
+#include <cerrno>
+#include <unistd.h>
+#include "enigma_simd.h"
+#include "enigma_stats.h"
+#include "enigma_trace.h"
+
+//オプションの判定に用いる定数
+#define BIT(num) ((unsigned int)1 << (num))
+#define NORMAL_MODE 0                       //(0000 0000 0000 0000)
+#define SHOW_TRANSITION_MODE BIT(0)         //(0000 0000 0000 0001)
+#define SHOW_DEFAULT_KEY_ARRAY_MODE BIT(1)  //(0000 0000 0000 0010)
+#define SHOW_KEY_ARRAY_MODE BIT(2)          //(0000 0000 0000 0100)
+#define READ_FILE_MODE BIT(3)               //(0000 0000 0000 1000)
+#define OUT_FILE_MODE BIT(4)                //(0000 0000 0001 0000)
+#define PERIOD_TABLE_MODE BIT(5)            //(0000 0000 0010 0000)
+#define BATCH_KERNEL_MODE BIT(6)            //(0000 0000 0100 0000)
+#define FILTER_MODE BIT(7)                  //(0000 0000 1000 0000)
+#define BATCH_JOB_MODE BIT(8)               //(0000 0001 0000 0000)
+#define ATTACK_MODE BIT(9)                  //(0000 0010 0000 0000)
+#define CRIB_MODE BIT(10)                   //(0000 0100 0000 0000)
+#define PLUGBOARD_SEARCH_MODE BIT(11)       //(0000 1000 0000 0000)
+#define NGRAM_BUILD_MODE BIT(12)            //(0001 0000 0000 0000)
+#define STATS_MODE BIT(13)                  //(0010 0000 0000 0000)
+#define CYCLE_STATS_MODE BIT(14)            //(0100 0000 0000 0000)
+#define TRACE_FILE_MODE BIT(15)             //(1000 0000 0000 0000)
+
+//4枚・5枚のリングでも使えるオプション(これ以外は3枚の配線を前提にしている)
+#define ROTOR_MODES (SHOW_DEFAULT_KEY_ARRAY_MODE | READ_FILE_MODE | OUT_FILE_MODE | FILTER_MODE \
+					 | STATS_MODE | CYCLE_STATS_MODE)
+
+//コピーコンストラクタと=演算子関数を無効にするためのマクロ
+#define DISALLOW_COPY_AND_ASSIGN(Typename)		\
+  Typename(const Typename&);					\
+  void operator=(const Typename&)
+
+//エニグマの各部品の配線(それぞれ括弧内の乱数の種から生成される配線と同じ)
+static const int PLUGBOARD_WIRING[26] = { //Plugboard(100)
+  11, 13, 15, 3, 23, 4, 1, 10, 18, 8, 19, 12, 20, 9, 2, 24, 21, 0, 16, 17, 6, 7, 25, 22, 14, 5
+};
+static const int RING1_WIRING[26] = {     //Scrambler(10)
+  12, 2, 13, 20, 21, 4, 24, 9, 25, 1, 10, 19, 5, 3, 7, 16, 0, 6, 15, 23, 14, 8, 22, 11, 17, 18
+};
+static const int RING2_WIRING[26] = {     //Scrambler(20)
+  9, 24, 11, 10, 4, 13, 7, 2, 15, 25, 1, 8, 0, 17, 6, 5, 14, 23, 12, 19, 22, 16, 20, 18, 3, 21
+};
+static const int RING3_WIRING[26] = {     //Scrambler(30)
+  8, 4, 13, 2, 24, 1, 15, 3, 0, 21, 5, 6, 11, 23, 10, 12, 20, 17, 9, 7, 14, 25, 16, 18, 22, 19
+};
+static const int RING4_WIRING[26] = {     //Scrambler(40)
+  6, 11, 16, 21, 12, 17, 1, 7, 9, 14, 15, 20, 4, 2, 3, 10, 0, 13, 24, 23, 8, 19, 25, 5, 22, 18
+};
+static const int RING5_WIRING[26] = {     //Scrambler(50)
+  4, 0, 3, 14, 2, 24, 6, 23, 5, 12, 8, 10, 18, 13, 15, 22, 9, 20, 21, 7, 1, 16, 17, 19, 11, 25
+};
+static const int REFLECTOR_WIRING[26] = { //Reflector(200)
+  7, 24, 3, 2, 5, 4, 18, 0, 9, 8, 13, 12, 11, 10, 22, 25, 21, 19, 6, 17, 23, 16, 14, 20, 1, 15
+};
+
+//リングの枚数の範囲(-sのキーの文字数で選ぶ.ring4,ring5は4枚・5枚のときだけ使う)
+static const int MIN_ROTORS = 3;
+static const int MAX_ROTORS = 5;
+static const int *const ROTOR_WIRINGS[MAX_ROTORS] = {
+  RING1_WIRING, RING2_WIRING, RING3_WIRING, RING4_WIRING, RING5_WIRING
+};
+
+//関数オブジェクトの定義
+struct ToUpper {
+  char operator()(char c){
+	return toupper(c);
+  }
+};
+struct IsDigit {
+  char operator()(char c){
+	return isdigit(c);
+  }
+};
+
+/**
+ * @brief 読み込んだブロックを暗号化できる形に整える
+ * @param [in] buf 読み込んだブロック
+ * @param [in] length ブロックのバイト数
+ * @param [out] code 空白と改行を除き,大文字に変換した文字列
+ * @return 数字が含まれていればfalse
+ * @detail -fで行ごとに読み込んで空白で分割し,連結してから大文字にするのと同じ結果になる
+ */
+inline bool NormalizeBlock(const char *buf, const size_t length, std::string &code){
+  code.clear();
+  for(size_t i = 0; i < length; i++){
+	char c = buf[i];
+	if(c == ' ' || c == '\n'){
+	  continue;
+	}
+	if(isdigit(c)){
+	  return false;
+	}
+	code += toupper(c);
+  }
+  return true;
+}
+
+/**
+ * @brief ジョブファイルの1行をキーとメッセージに分ける
+ * @param [in] line "KEY MESSAGE"の形の1行(キーとメッセージは空白かタブで区切る)
+ * @param [out] key 大文字に変換したキー
+ * @param [out] code 空白を除き,大文字に変換したメッセージ
+ * @param [in] rotors リングの枚数(キーの文字数)
+ * @return キーがアルファベットrotors文字でないか,メッセージに数字が含まれていればfalse
+ * @detail キーとメッセージの検査は-sと-fのものと同じ
+ */
+inline bool ParseJob(const std::string &line, std::string &key, std::string &code, const unsigned int rotors = 3){
+  size_t end = line.find_first_of(" \t");
+  key = line.substr(0, end);
+  std::transform(key.begin(), key.end(), key.begin(), ToUpper());
+  if(std::any_of(key.begin(), key.end(), IsDigit()) || key.length() != rotors){
+	return false;
+  }
+  if(end == std::string::npos){
+	code.clear();
+	return true;
+  }
+  return NormalizeBlock(line.data() + end + 1, line.length() - end - 1, code);
+}
+
+//文字->アルファベットのIDの対応表(大文字アルファベット以外の文字はIDを0とする)
+static constexpr uint8_t ALPHA_ID_TABLE[256] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+  15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+//アルファベットのID->文字の対応表
+static constexpr char ALPHA_TABLE[27] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+/**
+ * @brief アルファベットを数字に対応付ける関数
+ * @param [in] c 文字
+ * @return アルファベットのID(大文字アルファベット以外は0)
+ */
+inline constexpr int Alpha2AlphaID(const char c){
+  return ALPHA_ID_TABLE[(unsigned char)c];
+}
+
+/**
+ * @brief 数字をアルファベットに対応付ける関数
+ * @param [in] id アルファベットのID(0~25)
+ * @return アルファベット
+ */
+inline constexpr char AlphaID2Alpha(const int id){
+  return ALPHA_TABLE[id];
+}
+
+/**
+ * @brief 文字列をまとめてアルファベットのIDの列に変換する関数
+ * @param [in] code 文字列
+ * @param [in] length 文字数
+ * @param [out] ids アルファベットのIDの列(length要素)
+ * @return なし
+ */
+inline void Alpha2AlphaID(const char *code, const size_t length, uint8_t *ids){
+  for(size_t i = 0; i < length; i++){
+	ids[i] = ALPHA_ID_TABLE[(unsigned char)code[i]];
+  }
+}
+
+/**
+ * @brief アルファベットのIDの列をまとめて文字列に変換する関数
+ * @param [in] ids アルファベットのIDの列
+ * @param [in] length 文字数
+ * @param [out] code 文字列(length要素)
+ * @return なし
+ */
+inline void AlphaID2Alpha(const uint8_t *ids, const size_t length, char *code){
+  for(size_t i = 0; i < length; i++){
+	code[i] = ALPHA_TABLE[ids[i]];
+  }
+}
+
+
+/**
+ * @class  Arguments
+ * @brief コマンドライン引数の情報を格納
+ */
+class Arguments{
+private:
+  std::string key_;           //エニグマのキーを格納するための変数(default:AAA)
+  std::string code_;          //暗号化（平文化）する文を格納するための変数
+  std::string in_file_name_;  //入力ファイル名を格納するための変数
+  std::string out_file_name_; //出力ファイル名を格納するための変数
+  unsigned int mode_;         //オプションを格納するための変数
+  unsigned long long offset_; //暗号化を始める位置(キーを合わせてからの文字数)
+  unsigned int jobs_;         //暗号化に用いるスレッド数
+  unsigned long long trace_from_; //変換経過を記録・表示し始める位置(メッセージの先頭から0で数える)
+  unsigned long long trace_to_; //変換経過を記録・表示し終える位置(この位置は含まない)
+  unsigned long long trace_every_; //変換経過を記録・表示する間隔
+  std::string trace_file_;    //変換経過を記録するバイナリトレースのファイル名
+  unsigned int processes_;    //キーの探索に用いるワーカープロセス数(0ならプロセスを分けない)
+  std::string checkpoint_;    //探索のチェックポイントのファイル名(空なら書き出さない)
+  double interval_;           //チェックポイントを書き出す間隔(秒)
+  std::string ngram_file_;    //書き出すn-gramのバイナリファイル名
+  std::string plugboard_;     //プラグボードのキー配列(大文字アルファベット26文字,空なら既定の配線)
+  std::string corpus_;        //n-gramの出現頻度を数える英文のファイル名
+  double budget_;             //プラグボードの探索に使う秒数
+  std::string crib_;          //既知平文攻撃のクリブ(平文の一部)
+  unsigned int candidates_;   //探索で表示するキーの候補の数
+  double threshold_;          //探索を打ち切る点数(0以下なら打ち切らない)
+  unsigned int score_;        //探索の採点方法(ScoreType)
+  DISALLOW_COPY_AND_ASSIGN(Arguments);
+public:
+  /**
+   * デフォルトコンストラクタ
+   */
+  Arguments(){
+	key_ = "OOO";
+	code_ = "";
+	in_file_name_ = "";
+	out_file_name_ = "";
+	mode_ = NORMAL_MODE;
+	offset_ = 0;
+	jobs_ = 1;
+	trace_from_ = 0;
+	trace_to_ = ULLONG_MAX;
+	trace_every_ = 1;
+	trace_file_ = "";
+	processes_ = 0;
+	checkpoint_ = "";
+	interval_ = 60.0;
+	ngram_file_ = "";
+	plugboard_ = "";
+	corpus_ = "";
+	budget_ = 10.0;
+	crib_ = "";
+	candidates_ = 5;
+	threshold_ = 0.0;
+	score_ = 0;
+  }
+        
+  /**
+   * デストラクタ
+   */
+  ~Arguments(){
+  }
+        
+  /**
+   * @brief key_に対するgetアクセサ
+   * @param なし
+   * @return key_の値
+   */
+  inline std::string getKey() const{
+	return key_;
+  }
+        
+  /**
+   * @brief key_に対するsetアクセサ
+   * @param [in] key key_にセットする値
+   * @return なし
+   */
+  inline void setKey(const std::string key){
+	key_ = key;
+  }
+        
+  /**
+   * @brief code_に対するgetアクセサ
+   * @param なし
+   * @return code_の値
+   */
+  inline std::string getCode() const{
+	return code_;
+  }
+        
+  /**
+   * @brief code_に対するsetアクセサ
+   * @param [in] code code_にセットする値
+   * @return なし
+   */
+  inline void setCode(const std::string code){
+	code_ = code;
+  }
+        
+  /**
+   * @brief in_file_name_に対するgetアクセサ
+   * @param なし
+   * @return in_file_name_の値
+   */
+  inline std::string getInFileName() const{
+	return in_file_name_;
+  }
+        
+  /**
+   * @brief in_file_name_に対するsetアクセサ
+   * @param [in] in_file_name in_file_name_にセットする値
+   * @return なし
+   */
+  inline void setInFileName(const std::string in_file_name){
+	in_file_name_ = in_file_name;
+  }
+        
+  /**
+   * @brief out_file_name_に対するgetアクセサ
+   * @param なし
+   * @return out_file_name_の値
+   */
+  inline std::string getOutFileName() const{
+	return out_file_name_;
+  }
+        
+  /**
+   * @brief out_file_name_に対するsetアクセサ
+   * @param [in] out_file_name out_file_name_にセットする値
+   * @return なし
+   */
+  inline void setOutFileName(const std::string out_file_name){
+	out_file_name_ = out_file_name;
+  }
+        
+  /**
+   * @brief mode_に対するgetアクセサ
+   * @param なし
+   * @return mode_の値
+   */
+  inline unsigned int getMode() const{
+	return mode_;
+  }
+        
+  /**
+   * @brief mode_に対するsetアクセサ
+   * @param [in] mode mode_にセットする値
+   * @return なし
+   */
+  inline void setMode(const unsigned int mode){
+	mode_ = mode;
+  }
+        
+  /**
+   * @brief offset_に対するgetアクセサ
+   * @param なし
+   * @return offset_の値
+   */
+  inline unsigned long long getOffset() const{
+	return offset_;
+  }
+        
+  /**
+   * @brief offset_に対するsetアクセサ
+   * @param [in] offset offset_にセットする値
+   * @return なし
+   */
+  inline void setOffset(const unsigned long long offset){
+	offset_ = offset;
+  }
+        
+  /**
+   * @brief jobs_に対するgetアクセサ
+   * @param なし
+   * @return jobs_の値
+   */
+  inline unsigned int getJobs() const{
+	return jobs_;
+  }
+        
+  /**
+   * @brief jobs_に対するsetアクセサ
+   * @param [in] jobs jobs_にセットする値
+   * @return なし
+   */
+  inline void setJobs(const unsigned int jobs){
+	jobs_ = jobs;
+  }
+        
+  /**
+   * @brief trace_from_に対するgetアクセサ
+   * @param なし
+   * @return trace_from_の値
+   */
+  inline unsigned long long getTraceFrom() const{
+	return trace_from_;
+  }
+        
+  /**
+   * @brief trace_from_に対するsetアクセサ
+   * @param [in] trace_from trace_from_にセットする値
+   * @return なし
+   */
+  inline void setTraceFrom(const unsigned long long trace_from){
+	trace_from_ = trace_from;
+  }
+        
+  /**
+   * @brief trace_to_に対するgetアクセサ
+   * @param なし
+   * @return trace_to_の値
+   */
+  inline unsigned long long getTraceTo() const{
+	return trace_to_;
+  }
+        
+  /**
+   * @brief trace_to_に対するsetアクセサ
+   * @param [in] trace_to trace_to_にセットする値
+   * @return なし
+   */
+  inline void setTraceTo(const unsigned long long trace_to){
+	trace_to_ = trace_to;
+  }
+        
+  /**
+   * @brief trace_every_に対するgetアクセサ
+   * @param なし
+   * @return trace_every_の値
+   */
+  inline unsigned long long getTraceEvery() const{
+	return trace_every_;
+  }
+        
+  /**
+   * @brief trace_every_に対するsetアクセサ
+   * @param [in] trace_every trace_every_にセットする値
+   * @return なし
+   */
+  inline void setTraceEvery(const unsigned long long trace_every){
+	trace_every_ = trace_every;
+  }
+        
+  /**
+   * @brief trace_file_に対するgetアクセサ
+   * @param なし
+   * @return trace_file_の値
+   */
+  inline std::string getTraceFile() const{
+	return trace_file_;
+  }
+        
+  /**
+   * @brief trace_file_に対するsetアクセサ
+   * @param [in] trace_file trace_file_にセットする値
+   * @return なし
+   */
+  inline void setTraceFile(const std::string trace_file){
+	trace_file_ = trace_file;
+  }
+        
+  /**
+   * @brief processes_に対するgetアクセサ
+   * @param なし
+   * @return processes_の値
+   */
+  inline unsigned int getProcesses() const{
+	return processes_;
+  }
+        
+  /**
+   * @brief processes_に対するsetアクセサ
+   * @param [in] processes processes_にセットする値
+   * @return なし
+   */
+  inline void setProcesses(const unsigned int processes){
+	processes_ = processes;
+  }
+        
+  /**
+   * @brief checkpoint_に対するgetアクセサ
+   * @param なし
+   * @return checkpoint_の値
+   */
+  inline std::string getCheckpoint() const{
+	return checkpoint_;
+  }
+        
+  /**
+   * @brief checkpoint_に対するsetアクセサ
+   * @param [in] checkpoint checkpoint_にセットする値
+   * @return なし
+   */
+  inline void setCheckpoint(const std::string checkpoint){
+	checkpoint_ = checkpoint;
+  }
+        
+  /**
+   * @brief interval_に対するgetアクセサ
+   * @param なし
+   * @return interval_の値
+   */
+  inline double getInterval() const{
+	return interval_;
+  }
+        
+  /**
+   * @brief interval_に対するsetアクセサ
+   * @param [in] interval interval_にセットする値
+   * @return なし
+   */
+  inline void setInterval(const double interval){
+	interval_ = interval;
+  }
+        
+  /**
+   * @brief ngram_file_に対するgetアクセサ
+   * @param なし
+   * @return ngram_file_の値
+   */
+  inline std::string getNgramFile() const{
+	return ngram_file_;
+  }
+        
+  /**
+   * @brief ngram_file_に対するsetアクセサ
+   * @param [in] ngram_file ngram_file_にセットする値
+   * @return なし
+   */
+  inline void setNgramFile(const std::string ngram_file){
+	ngram_file_ = ngram_file;
+  }
+        
+  /**
+   * @brief plugboard_に対するgetアクセサ
+   * @param なし
+   * @return plugboard_の値
+   */
+  inline std::string getPlugboard() const{
+	return plugboard_;
+  }
+        
+  /**
+   * @brief plugboard_に対するsetアクセサ
+   * @param [in] plugboard plugboard_にセットする値
+   * @return なし
+   */
+  inline void setPlugboard(const std::string plugboard){
+	plugboard_ = plugboard;
+  }
+        
+  /**
+   * @brief corpus_に対するgetアクセサ
+   * @param なし
+   * @return corpus_の値
+   */
+  inline std::string getCorpus() const{
+	return corpus_;
+  }
+        
+  /**
+   * @brief corpus_に対するsetアクセサ
+   * @param [in] corpus corpus_にセットする値
+   * @return なし
+   */
+  inline void setCorpus(const std::string corpus){
+	corpus_ = corpus;
+  }
+        
+  /**
+   * @brief budget_に対するgetアクセサ
+   * @param なし
+   * @return budget_の値
+   */
+  inline double getBudget() const{
+	return budget_;
+  }
+        
+  /**
+   * @brief budget_に対するsetアクセサ
+   * @param [in] budget budget_にセットする値
+   * @return なし
+   */
+  inline void setBudget(const double budget){
+	budget_ = budget;
+  }
+        
+  /**
+   * @brief crib_に対するgetアクセサ
+   * @param なし
+   * @return crib_の値
+   */
+  inline std::string getCrib() const{
+	return crib_;
+  }
+        
+  /**
+   * @brief crib_に対するsetアクセサ
+   * @param [in] crib crib_にセットする値
+   * @return なし
+   */
+  inline void setCrib(const std::string crib){
+	crib_ = crib;
+  }
+        
+  /**
+   * @brief candidates_に対するgetアクセサ
+   * @param なし
+   * @return candidates_の値
+   */
+  inline unsigned int getCandidates() const{
+	return candidates_;
+  }
+        
+  /**
+   * @brief candidates_に対するsetアクセサ
+   * @param [in] candidates candidates_にセットする値
+   * @return なし
+   */
+  inline void setCandidates(const unsigned int candidates){
+	candidates_ = candidates;
+  }
+        
+  /**
+   * @brief threshold_に対するgetアクセサ
+   * @param なし
+   * @return threshold_の値
+   */
+  inline double getThreshold() const{
+	return threshold_;
+  }
+        
+  /**
+   * @brief threshold_に対するsetアクセサ
+   * @param [in] threshold threshold_にセットする値
+   * @return なし
+   */
+  inline void setThreshold(const double threshold){
+	threshold_ = threshold;
+  }
+        
+  /**
+   * @brief score_に対するgetアクセサ
+   * @param なし
+   * @return score_の値
+   */
+  inline unsigned int getScore() const{
+	return score_;
+  }
+        
+  /**
+   * @brief score_に対するsetアクセサ
+   * @param [in] score score_にセットする値
+   * @return なし
+   */
+  inline void setScore(const unsigned int score){
+	score_ = score;
+  }
+};
+
+/**
+ * @class  Plugboard
+ * @brief エニグマのプラグボード部分を実装
+ */
+class Plugboard{
+private:
+  uint8_t plugboard[26]; //プラグボードのキー配列
+  uint8_t inverse[26];   //キー配列の逆写像(帰りの変換に用いる)
+
+  /**
+   * @brief キー配列から逆写像を作成する
+   * @param なし
+   * @return なし
+   */
+  void MakeInverse(){
+	for(int i = 0; i < 26; i++){
+	  inverse[plugboard[i]] = i;
+	}
+  }
+public:
+  /**
+   * デフォルトコンストラクタ
+   */
+  Plugboard(){
+	for(int i = 0; i < 26; i++){
+	  plugboard[i] = i;
+	}
+	MakeInverse();
+  }
+  /**
+   * コンストラクタ
+   * @param [in] キー配列を初期化する乱数の種
+   */
+  explicit Plugboard(const unsigned int seed){
+	for(int i = 0; i < 26; i++){
+	  plugboard[i] = i;
+	}
+	srand(seed);
+	std::random_shuffle(plugboard, plugboard + 26);
+	MakeInverse();
+  }
+  /**
+   * コンストラクタ
+   * @param [in] wiring キー配列(26要素)
+   */
+  explicit Plugboard(const int *wiring){
+	for(int i = 0; i < 26; i++){
+	  plugboard[i] = wiring[i];
+	}
+	MakeInverse();
+  }
+        
+  /**
+   * @brief 暗号化を行う(行き)
+   * @param [in] code アルファベットのID
+   * @return 換字されたアルファベットのID
+   */
+  inline int GoingEncipher(const int code) const{
+	return plugboard[code];
+  }
+        
+  /**
+   * @brief 暗号化を行う(帰り)
+   * @param [in] code アルファベットのID
+   * @return 換字されたアルファベットのID
+   */
+  inline int ReturningEncipher(const int code) const{
+	return inverse[code];
+  }
+        
+  /**
+   * @brief 一括暗号化カーネル用にキー配列と逆写像を書き出す
+   * @param [out] going キー配列(32バイト)
+   * @param [out] returning 逆写像(32バイト)
+   * @return なし
+   */
+  void ExportTables(uint8_t *going, uint8_t *returning) const{
+	for(int i = 0; i < 32; i++){
+	  going[i] = (i < 26) ? plugboard[i] : 0;
+	  returning[i] = (i < 26) ? inverse[i] : 0;
+	}
+  }
+        
+  /**
+   * @brief キー配列のa番目とb番目を入れ替える
+   * @param [in] a アルファベットのID
+   * @param [in] b アルファベットのID
+   * @return なし
+   */
+  inline void Swap(const int a, const int b){
+	std::swap(plugboard[a], plugboard[b]);
+	inverse[plugboard[a]] = a;
+	inverse[plugboard[b]] = b;
+  }
+        
+  /**
+   * @brief キー配列を文字列にする
+   * @param なし
+   * @return 大文字アルファベット26文字のキー配列(-Pに渡せる形)
+   */
+  std::string ToString() const{
+	std::string wiring(26, 'A');
+	for(int i = 0; i < 26; i++){
+	  wiring[i] = AlphaID2Alpha(plugboard[i]);
+	}
+	return wiring;
+  }
+        
+  /**
+   * @brief キー配列を表示する
+   * @param なし
+   * @return なし
+   */
+  void ShowKeyArray() const{
+	int tmp;
+	std::cout << "\t  Plugboard [ " ;
+	for(unsigned int i=0; i<26; i++){
+	  tmp = plugboard[i];
+	  std::cout << AlphaID2Alpha(tmp) << " ";
+	}
+	std::cout << "]" << std::endl;
+  }
+};
+
+/**
+ * @brief 文字列からプラグボードを作る
+ * @param [in] wiring 大文字アルファベット26文字のキー配列(i文字目がiのつながる先)
+ * @param [out] plugboard 作ったプラグボード
+ * @return 26文字のアルファベットを1回ずつ並べたものでなければfalse
+ */
+inline bool ParsePlugboard(const std::string &wiring, Plugboard &plugboard){
+  if(wiring.length() != 26){
+	return false;
+  }
+  int table[26];
+  bool used[26] = {false};
+  for(int i = 0; i < 26; i++){
+	if(!isupper(wiring[i]) || used[Alpha2AlphaID(wiring[i])]){
+	  return false;
+	}
+	table[i] = Alpha2AlphaID(wiring[i]);
+	used[table[i]] = true;
+  }
+  plugboard = Plugboard(table);
+  return true;
+}
+
+/**
+ * @class Scrambler
+ * @brief エニグマのスクランブラー（歯車）を実装
+ * @detail 固定の配線だけを持ち,回転位置posは呼び出し側(RingCursor)から受け取る.
+ *         位置posのときのキー配列はrotor[i] = wiring[(i - pos) mod 26]となる
+ */
+class Scrambler{
+private:
+  uint8_t wiring[52];  //スクランブラーの配線(添字の計算で剰余を取らずに済むよう２周分持つ)
+  uint8_t inverse[26]; //配線の逆写像
+
+  /**
+   * @brief 配線から逆写像と２周分の配線を作成する
+   * @param なし
+   * @return なし
+   */
+  void MakeTables(){
+	for(int i = 0; i < 26; i++){
+	  wiring[i + 26] = wiring[i];
+	  inverse[wiring[i]] = i;
+	}
+  }
+public:
+  /**
+   * デフォルトコンストラクタ
+   */
+  Scrambler(){
+	for(int i = 0; i < 26; i++){
+	  wiring[i] = i;
+	}
+	MakeTables();
+  }
+        
+  /**
+   * コンストラクタ
+   * @param [in] キー配列を初期化する乱数の種
+   */
+  explicit Scrambler(const unsigned int seed){
+	for(int i = 0; i < 26; i++){
+	  wiring[i] = i;
+	}
+	srand(seed);
+	std::random_shuffle(wiring, wiring + 26);
+	MakeTables();
+  }
+        
+  /**
+   * コンストラクタ
+   * @param [in] table 配線(26要素)
+   */
+  explicit Scrambler(const int *table){
+	for(int i = 0; i < 26; i++){
+	  wiring[i] = table[i];
+	}
+	MakeTables();
+  }
+        
+  /**
+   * @brief 指定のキーに合わせたときの回転位置を求める
+   * @param [in] key 合わせるキー(キー配列の先頭に来るアルファベットのID)
+   * @return スクランブラーの回転位置
+   */
+  inline int KeyPos(const int key) const{
+	//rotor[0] = wiring[-pos mod 26] = key となる位置を逆写像から求める
+	return (26 - inverse[key]) % 26;
+  }
+        
+  /**
+   * @brief 暗号化を行う(行き)
+   * @param [in] code アルファベットのID
+   * @param [in] pos スクランブラーの回転位置
+   * @return 換字されたアルファベットのID
+   */
+  inline int GoingEncipher(const int code, const int pos) const{
+	return wiring[code + 26 - pos];
+  }
+        
+  /**
+   * @brief 暗号化を行う(帰り)
+   * @param [in] code アルファベットのID
+   * @param [in] pos スクランブラーの回転位置
+   * @return 換字されたアルファベットのID
+   */
+  inline int ReturningEncipher(const int code, const int pos) const{
+	int code_ = inverse[code] + pos;
+	return (code_ < 26) ? code_ : code_ - 26;
+  }
+        
+  /**
+   * @brief 一括暗号化カーネル用に位置0での配線と逆写像を書き出す
+   * @param [out] going 配線(32バイト)
+   * @param [out] returning 逆写像(32バイト)
+   * @return なし
+   */
+  void ExportTables(uint8_t *going, uint8_t *returning) const{
+	for(int i = 0; i < 32; i++){
+	  going[i] = (i < 26) ? wiring[i] : 0;
+	  returning[i] = (i < 26) ? inverse[i] : 0;
+	}
+  }
+        
+  /**
+   * @brief キー配列を表示する
+   * @param [in] pos スクランブラーの回転位置
+   * @return なし
+   */
+  void ShowKeyArray(const int pos) const{
+	int tmp;
+	std::cout << "[ " ;
+	for(unsigned int i=0; i<26; i++){
+	  tmp = wiring[i + 26 - pos];
+	  std::cout << AlphaID2Alpha(tmp) << " ";
+	}
+	std::cout << "]" << std::endl;
+  }
+};
+
+/**
+ * @class Reflector
+ * @brief エニグマのリフレクターを実装
+ */
+class Reflector{
+private:
+  uint8_t reflector[26]; //リフレクターのキー配列
+public:
+  /**
+   * デフォルトコンストラクタ
+   */
+  Reflector(){
+	for(int i = 0; i < 26; i++){
+	  reflector[i] = 25 - i;
+	}
+  }
+  /**
+   * コンストラクタ
+   * @param [in] キー配列を初期化する乱数の種
+   * @detail 例えば入力Aが出力Bに変換されるなら,入力Bは出力Aに変換されるように初期化
+   */
+  explicit Reflector(const unsigned int seed){
+	for(int i = 0; i < 26; i++){
+	  reflector[i] = i;
+	}
+	std::vector<int> ref_copy(reflector, reflector + 26);
+	srand(seed);
+	random_shuffle(ref_copy.begin(), ref_copy.end());
+	for(int i=0; i < 13; i++){
+	  //swapで入出力の対応関係を保った初期化を行う
+	  std::swap(reflector[(ref_copy[i])], reflector[(ref_copy[25-i])]);
+	}
+  }
+  /**
+   * コンストラクタ
+   * @param [in] wiring キー配列(26要素,入出力の対応関係が対称なもの)
+   */
+  explicit Reflector(const int *wiring){
+	for(int i = 0; i < 26; i++){
+	  reflector[i] = wiring[i];
+	}
+  }
+        
+  /**
+   * @brief 暗号化を行う
+   * @param [in] code アルファベットのID
+   * @return 換字されたアルファベットのID
+   */
+  inline int Reflect(const int code) const{
+	return reflector[code];
+  }
+        
+  /**
+   * @brief 一括暗号化カーネル用にキー配列を書き出す
+   * @param [out] table キー配列(32バイト)
+   * @return なし
+   */
+  void ExportTables(uint8_t *table) const{
+	for(int i = 0; i < 32; i++){
+	  table[i] = (i < 26) ? reflector[i] : 0;
+	}
+  }
+        
+  /**
+   * @brief キー配列を表示する
+   * @param なし
+   * @return なし
+   */
+  void ShowKeyArray() const{
+	int tmp;
+	std::cout << "\t  Reflector [ " ;
+	for(unsigned int i=0; i<26; i++){
+	  tmp = reflector[i];
+	  std::cout << AlphaID2Alpha(tmp) << " ";
+	}
+	std::cout << "]" << std::endl;
+  }
+        
+};
+
+/**
+ * @brief リングがn枚のときにスクランブラーの状態が一巡する文字数を返す
+ * @param [in] n リングの枚数
+ * @return 26のn乗
+ */
+inline constexpr unsigned long long RotorPeriod(const int n){
+  return (n == 0) ? 1 : 26 * RotorPeriod(n - 1);
+}
+
+/**
+ * @class BasicRingCursor
+ * @brief キー(キーを合わせた直後のリングの位置)と現在の位置を持つカーソル
+ * @tparam N リングの枚数
+ * @detail 配線は持たず(3枚なら)16バイトに収まるので,スレッドごと・メッセージごとに持たせる.
+ *         ring1は1文字ごとに1目盛り回り,キーを合わせた位置に戻る(1回転する)たびに
+ *         次のリングを1目盛り回す.この繰り上がりはリングの番号ごとのCarryの連鎖として
+ *         コンパイル時に展開するので,枚数によらず実行時のループや間接呼び出しを通らない
+ */
+template<int N>
+class BasicRingCursor{
+  static_assert(N >= 1, "BasicRingCursor needs at least one rotor");
+private:
+  typedef std::integral_constant<int, N - 1> LastRing; //最後のリング
+  unsigned long long offset = 0; //キーを合わせてから暗号化した文字数
+  uint8_t startPos[N] = {};      //キーを合わせた直後のそれぞれのリングの位置
+  uint8_t pos[N] = {};           //それぞれのリングの現在の位置
+
+  /**
+   * @brief リングを1目盛り回す
+   * @param [in] i リングの番号(0~N-1)
+   * @return リングが1回転して次のリングを回すならtrue
+   */
+  inline bool Step(const int i){
+	pos[i] = (pos[i] == 25) ? 0 : pos[i] + 1;
+	return pos[i] == startPos[i];
+  }
+
+  /**
+   * @brief リングIを1目盛り回し,1回転したら次のリングを回す
+   * @tparam I リングの番号
+   * @return なし
+   */
+  template<int I>
+  inline void Carry(std::integral_constant<int, I>){
+	if(Step(I)){
+	  ENIGMA_COUNT(COUNTER_ROTOR_TURNOVERS, 1);
+	  Carry(std::integral_constant<int, I + 1>());
+	}
+  }
+
+  /**
+   * @brief 最後のリングを1目盛り回す(次のリングはないので連鎖はここで終わる)
+   * @return なし
+   */
+  inline void Carry(LastRing){
+	Step(N - 1);
+  }
+public:
+  /**
+   * デフォルトコンストラクタ
+   */
+  BasicRingCursor(){
+  }
+        
+  /**
+   * コンストラクタ
+   * @param [in] start キーを合わせた直後のそれぞれのリングの位置(N要素)
+   */
+  explicit BasicRingCursor(const int *start){
+	for(int i = 0; i < N; i++){
+	  startPos[i] = start[i];
+	  pos[i] = start[i];
+	}
+  }
+        
+  /**
+   * @brief offsetに対するgetアクセサ
+   * @param なし
+   * @return キーを合わせてから暗号化した文字数
+   */
+  inline unsigned long long getOffset() const{
+	return offset;
+  }
+        
+  /**
+   * @brief posに対するgetアクセサ
+   * @param [in] i リングの番号(0~N-1)
+   * @return リングの現在の位置
+   */
+  inline int getPos(const int i) const{
+	return pos[i];
+  }
+        
+  /**
+   * @brief startPosに対するgetアクセサ
+   * @param [in] i リングの番号(0~N-1)
+   * @return キーを合わせた直後のリングの位置
+   */
+  inline int getStartPos(const int i) const{
+	return startPos[i];
+  }
+        
+  /**
+   * @brief ring1のキーの配置を変える
+   * @param なし
+   * @return なし
+   * @detail ring1が1回転したらring2を,ring2が1回転したらring3を回す(以下同様)
+   */
+  inline void EndCycle(){
+	Carry(std::integral_constant<int, 0>());
+	offset++;
+  }
+        
+  /**
+   * @brief キーを合わせてからn文字暗号化した後の状態に直接合わせる
+   * @param [in] n キーを合わせてからの文字数
+   * @return なし
+   * @detail ring(i+1)はn/26^i目盛り回った状態になる
+   */
+  void Seek(const unsigned long long n){
+	unsigned long long turns = n;
+	for(int i = 0; i < N; i++){
+	  pos[i] = (startPos[i] + turns % 26) % 26;
+	  turns /= 26;
+	}
+	offset = n;
+  }
+        
+  /**
+   * @brief n文字分スクランブラーを進める
+   * @param [in] n 進める文字数
+   * @return なし
+   */
+  void Advance(const unsigned long long n){
+	Seek(offset + n);
+  }
+};
+
+//3枚のリングのカーソル(換字表や一括暗号化カーネルなどはこの枚数を前提にする)
+typedef BasicRingCursor<3> RingCursor;
+
+/**
+ * @class BasicRingSet
+ * @brief スクランブラーを統括する
+ * @tparam N リングの枚数(MAX_ROTORS以下)
+ * @detail N枚のリングの配線だけを持つ.回転位置はBasicRingCursorで受け取る.
+ *         行き・帰りの換字はリングの番号ごとのGoing/Returningの連鎖としてコンパイル時に展開する
+ */
+template<int N>
+class BasicRingSet{
+  static_assert(N >= 1 && N <= MAX_ROTORS, "BasicRingSet supports 1 to MAX_ROTORS rotors");
+private:
+  Scrambler rings[N]; //ring1から順のリング
+
+  /**
+   * @brief リングI以降を通す(行き)
+   * @tparam I リングの番号
+   * @param [in] cursor リングの位置
+   * @param [in] code アルファベットのID
+   * @return 換字されたアルファベットのID
+   */
+  template<int I>
+  inline int Going(std::integral_constant<int, I>, const BasicRingCursor<N> &cursor, const int code) const{
+	return Going(std::integral_constant<int, I + 1>(), cursor, rings[I].GoingEncipher(code, cursor.getPos(I)));
+  }
+
+  /**
+   * @brief 最後のリングを通った後(連鎖はここで終わる)
+   * @param [in] code アルファベットのID
+   * @return code
+   */
+  inline int Going(std::integral_constant<int, N>, const BasicRingCursor<N> &, const int code) const{
+	return code;
+  }
+
+  /**
+   * @brief リングI以降を通す(帰り.最後のリングから順にリングIまで)
+   * @tparam I リングの番号
+   * @param [in] cursor リングの位置
+   * @param [in] code アルファベットのID
+   * @return 換字されたアルファベットのID
+   */
+  template<int I>
+  inline int Returning(std::integral_constant<int, I>, const BasicRingCursor<N> &cursor, const int code) const{
+	return rings[I].ReturningEncipher(Returning(std::integral_constant<int, I + 1>(), cursor, code), cursor.getPos(I));
+  }
+
+  /**
+   * @brief 最後のリングを通る前(連鎖はここで終わる)
+   * @param [in] code アルファベットのID
+   * @return code
+   */
+  inline int Returning(std::integral_constant<int, N>, const BasicRingCursor<N> &, const int code) const{
+	return code;
+  }
+public:
+  static const unsigned int PERIOD = RotorPeriod(N); //スクランブラーの状態が一巡する文字数
+        
+  /**
+   * デフォルトコンストラクタ
+   */
+  BasicRingSet(){
+	for(int i = 0; i < N; i++){
+	  rings[i] = Scrambler(ROTOR_WIRINGS[i]);
+	}
+  }
+        
+  /**
+   * @brief それぞれのリングのキーを合わせたカーソルを作る
+   * @param [in] keyset それぞれのリングのキーのID(N要素)
+   * @return キーを合わせた直後のカーソル
+   */
+  BasicRingCursor<N> KeySet(const int *keyset) const{
+	int start[N];
+	for(int i = 0; i < N; i++){
+	  start[i] = rings[i].KeyPos(keyset[i]);
+	}
+	return BasicRingCursor<N>(start);
+  }
+        
+  /**
+   * @brief それぞれのリングの現在のキーを求める(KeySetの逆)
+   * @param [in] cursor リングの位置
+   * @param [out] keyset それぞれのリングのキー配列の先頭にあるアルファベットのID(N要素)
+   * @return なし
+   */
+  void CurrentKey(const BasicRingCursor<N> &cursor, int *keyset) const{
+	for(int i = 0; i < N; i++){
+	  keyset[i] = rings[i].GoingEncipher(0, cursor.getPos(i));
+	}
+  }
+        
+  /**
+   * @brief 暗号化を行う(行き)
+   * @param [in] cursor リングの位置
+   * @param [in] code アルファベットのID
+   * @return 換字されたアルファベットのID
+   */
+  inline int GoingEncipher(const BasicRingCursor<N> &cursor, const int code) const{
+	return Going(std::integral_constant<int, 0>(), cursor, code);
+  }
+
+  /**
+   * @brief 暗号化を行う(帰り)
+   * @param [in] cursor リングの位置
+   * @param [in] code アルファベットのID
+   * @return 換字されたアルファベットのID
+   */
+  inline int ReturningEncipher(const BasicRingCursor<N> &cursor, const int code) const{
+	return Returning(std::integral_constant<int, 0>(), cursor, code);
+  }
+        
+  /**
+   * @brief 暗号化を行い,それぞれのリングを通った後のIDを記録する(行き)
+   * @param [in] cursor リングの位置
+   * @param [in] code アルファベットのID
+   * @param [out] ids ring1~Nを通った後のID(N要素)
+   * @return 換字されたアルファベットのID
+   */
+  inline int TraceGoingEncipher(const BasicRingCursor<N> &cursor, const int code, uint8_t *ids) const{
+	int code_ = code;
+	for(int i = 0; i < N; i++){
+	  ids[i] = code_ = rings[i].GoingEncipher(code_, cursor.getPos(i));
+	}
+	return code_;
+  }
+
+  /**
+   * @brief 暗号化を行い,それぞれのリングを通った後のIDを記録する(帰り)
+   * @param [in] cursor リングの位置
+   * @param [in] code アルファベットのID
+   * @param [out] ids ringN~1を通った後のID(N要素)
+   * @return 換字されたアルファベットのID
+   */
+  inline int TraceReturningEncipher(const BasicRingCursor<N> &cursor, const int code, uint8_t *ids) const{
+	int code_ = code;
+	for(int i = 0; i < N; i++){
+	  ids[i] = code_ = rings[N - 1 - i].ReturningEncipher(code_, cursor.getPos(N - 1 - i));
+	}
+	return code_;
+  }
+        
+  /**
+   * @brief 一括暗号化カーネル用に配線とキーを合わせた直後の位置を書き出す
+   * @param [in] cursor リングの位置
+   * @param [out] tables 書き出し先
+   * @return なし
+   * @detail カーネルは3枚のリングを前提にしているので,3枚のときだけ使える
+   */
+  void ExportTables(const BasicRingCursor<N> &cursor, BatchTables &tables) const{
+	static_assert(N == 3, "BatchTables holds exactly 3 rotors");
+	for(int i = 0; i < N; i++){
+	  rings[i].ExportTables(tables.rotor[i], tables.rotorInverse[i]);
+	  tables.start[i] = cursor.getStartPos(i);
+	}
+  }
+        
+  /**
+   * @brief キー配列を表示する
+   * @param [in] cursor リングの位置
+   * @return なし
+   */
+  void ShowKeyArray(const BasicRingCursor<N> &cursor) const{
+	for(int i = 0; i < N; i++){
+	  std::cout << "\t  Ring" << i + 1 << "     ";
+	  rings[i].ShowKeyArray(cursor.getPos(i));
+	}
+  }
+};
+
+//3枚のリング(換字表や一括暗号化カーネルなどはこの枚数を前提にする)
+typedef BasicRingSet<3> RingSet;
+
+/**
+ * @class SubstitutionTable
+ * @brief あるキーに対する1周期分の換字表
+ * @detail キーを合わせてからpos文字目(pos < RingSet::PERIOD)の文字の換字結果を
+ *         table[pos * 26 + code]に持つ(17,576 x 26 バイト)
+ */
+class SubstitutionTable{
+private:
+  std::vector<unsigned char> table; //位置ごとの換字表
+  DISALLOW_COPY_AND_ASSIGN(SubstitutionTable);
+public:
+  /**
+   * デフォルトコンストラクタ
+   */
+  SubstitutionTable() : table(RingSet::PERIOD * 26){
+  }
+        
+  /**
+   * @brief 換字結果を登録する
+   * @param [in] pos 周期内の位置
+   * @param [in] code アルファベットのID
+   * @param [in] cipher 換字されたアルファベットのID
+   * @return なし
+   */
+  inline void Set(const unsigned int pos, const int code, const int cipher){
+	table[pos * 26 + code] = cipher;
+  }
+        
+  /**
+   * @brief 換字結果を引く
+   * @param [in] pos 周期内の位置
+   * @param [in] code アルファベットのID
+   * @return 換字されたアルファベットのID
+   */
+  inline int Lookup(const unsigned int pos, const int code) const{
+	return table[pos * 26 + code];
+  }
+};
+
+/**
+ * @class BasicEnigmaConfig
+ * @brief エニグマの配線(プラグボード,リング,リフレクター)を実装
+ * @tparam N リングの枚数(MIN_ROTORS~MAX_ROTORS.-sのキーの文字数で選ぶ)
+ * @detail 構築後は変更されないので,1つのインスタンスを複数のスレッドで共有できる.
+ *         キーと位置はBasicRingCursorとして呼び出し側が持ち,暗号化の関数に渡す.
+ *         換字表(-p),一括暗号化カーネル(-v),複数キーの同時暗号化とトレースは3枚の配線を
+ *         前提にしているので,3枚のときだけ使える(それ以外の枚数では1文字ずつ暗号化する)
+ */
+template<int N>
+class BasicEnigmaConfig{
+  static_assert(N >= MIN_ROTORS && N <= MAX_ROTORS, "BasicEnigmaConfig supports MIN_ROTORS to MAX_ROTORS rotors");
+public:
+  typedef std::integral_constant<bool, N == 3> HasBatchTables; //3枚の配線を前提にしたエンジンを使えるか
+private:
+  Plugboard plugboard;
+  BasicRingSet<N> ringSet;
+  Reflector reflector;
+        
+  /**
+   * @brief キーに対する換字表を返す
+   * @param [in] cursor キーを合わせたカーソル
+   * @return 換字表
+   * @detail リングとリフレクターの配線はどのインスタンスでも同じなので,一度作った換字表は
+   *         プラグボードとキー(キーを合わせた直後のリングの位置)の組ごとにキャッシュし,
+   *         同じ組では作り直さない.1つの換字表は約457KBあるので,キャッシュは最近使った
+   *         TABLE_CACHE_SIZE個までとし,それを超えたら最も長く使っていないものから捨てる
+   *         (使用中の換字表はshared_ptrで呼び出し側が持つので,捨てても解放は使い終わってから)
+   */
+  std::shared_ptr<const SubstitutionTable> FindTable(const BasicRingCursor<N> &cursor) const{
+	static_assert(N == 3, "SubstitutionTable holds the period of 3 rotors");
+	static const size_t TABLE_CACHE_SIZE = 4;
+	typedef std::pair<std::pair<std::string, int>, std::shared_ptr<const SubstitutionTable> > CacheEntry;
+	static std::mutex mtx;
+	static std::list<CacheEntry> cache; //先頭ほど最近使った換字表
+	int start[3] = {cursor.getStartPos(0), cursor.getStartPos(1), cursor.getStartPos(2)};
+	std::pair<std::string, int> id(plugboard.ToString(), (start[0] * 26 + start[1]) * 26 + start[2]);
+	std::lock_guard<std::mutex> lock(mtx);
+	for(std::list<CacheEntry>::iterator it = cache.begin(); it != cache.end(); ++it){
+	  if(it->first == id){
+		cache.splice(cache.begin(), cache, it);
+		return it->second;
+	  }
+	}
+            
+	/*キーを合わせたばかりのカーソルを1周期分回して換字表を作る*/
+	std::shared_ptr<SubstitutionTable> table(new SubstitutionTable());
+	BasicRingCursor<N> builder(start);
+	for(unsigned int pos = 0; pos < BasicRingSet<N>::PERIOD; pos++){
+	  for(int code = 0; code < 26; code++){
+		table->Set(pos, code, Encipher(builder, code));
+	  }
+	  builder.EndCycle();
+	}
+	cache.push_front(CacheEntry(id, table));
+	if(cache.size() > TABLE_CACHE_SIZE){
+	  cache.pop_back();
+	}
+	return table;
+  }
+        
+  /**
+   * モードに応じたエンジン(換字表,一括暗号化カーネル,通常)で暗号化(複号化)を行う(3枚のとき)
+   * @param [in,out] cursor リングの位置(暗号化した文字数だけ進む)
+   * @param [in] code この入力に対してEnigmaを実行する
+   * @param [in] mode オプション(PERIOD_TABLE_MODE, BATCH_KERNEL_MODEを見る)
+   * @return Enigmaによる変換後の文字列
+   */
+  std::string EncryptionByMode(BasicRingCursor<N> &cursor, const std::string &code,
+							   const unsigned int mode, std::true_type) const{
+	if(mode & PERIOD_TABLE_MODE){
+	  return TableEncryption(cursor, code);
+	}else if(mode & BATCH_KERNEL_MODE){
+	  return BatchEncryption(cursor, code);
+	}else{
+	  return Encryption(cursor, code);
+	}
+  }
+        
+  /**
+   * 暗号化(複号化)を行う(3枚以外のとき.換字表と一括暗号化カーネルは使えない)
+   * @param [in,out] cursor リングの位置(暗号化した文字数だけ進む)
+   * @param [in] code この入力に対してEnigmaを実行する
+   * @return Enigmaによる変換後の文字列
+   */
+  std::string EncryptionByMode(BasicRingCursor<N> &cursor, const std::string &code,
+							   const unsigned int, std::false_type) const{
+	return Encryption(cursor, code);
+  }
+        
+  /**
+   * @brief IDの列をその場で暗号化(複号化)する(3枚のとき.一括暗号化カーネルを使う)
+   * @param [in,out] cursor リングの位置(暗号化した文字数だけ進む)
+   * @param [in,out] ids アルファベットのIDの列
+   * @param [in] length 文字数
+   * @return なし
+   */
+  void EncipherIds(BasicRingCursor<N> &cursor, uint8_t *ids, const size_t length, std::true_type) const{
+	BatchTables tables;
+	ExportTables(cursor, tables);
+	BatchEncipher(tables, ids, ids, length, cursor.getOffset());
+	ENIGMA_COUNT(COUNTER_ROTOR_TURNOVERS, CountTurnovers(cursor.getOffset(), length));
+	cursor.Advance(length);
+  }
+        
+  /**
+   * @brief IDの列をその場で暗号化(複号化)する(3枚以外のとき.1文字ずつ)
+   * @param [in,out] cursor リングの位置(暗号化した文字数だけ進む)
+   * @param [in,out] ids アルファベットのIDの列
+   * @param [in] length 文字数
+   * @return なし
+   */
+  void EncipherIds(BasicRingCursor<N> &cursor, uint8_t *ids, const size_t length, std::false_type) const{
+	for(size_t i = 0; i < length; i++){
+	  ids[i] = Encipher(cursor, ids[i]);
+	  cursor.EndCycle();
+	}
+  }
+public:
+  /**
+   * デフォルトコンストラクタ
+   */
+  BasicEnigmaConfig() : plugboard(PLUGBOARD_WIRING), ringSet(), reflector(REFLECTOR_WIRING){
+  }
+        
+  /**
+   * コンストラクタ
+   * @param [in] plugboard プラグボード(リングとリフレクターは既定の配線)
+   */
+  explicit BasicEnigmaConfig(const Plugboard &plugboard)
+	: plugboard(plugboard), ringSet(), reflector(REFLECTOR_WIRING){
+  }
+        
+  /**
+   * @brief plugboardに対するgetアクセサ
+   * @param なし
+   * @return プラグボード
+   */
+  inline const Plugboard &getPlugboard() const{
+	return plugboard;
+  }
+        
+  /**
+   * それぞれのリングにキーを合わせたカーソルを作る
+   * @param [in] key キーが大文字アルファベットN文字で与えられる
+   * @return キーを合わせた直後のカーソル
+   */
+  BasicRingCursor<N> KeySet(const std::string key) const{
+	/*keyを対応表に則ってint型に変更する*/
+	int key_temp[N] = {};
+	for(unsigned int i = 0; i<key.length() && i<N; i++){
+	  key_temp[i] = Alpha2AlphaID(key[i]);
+	}
+	/*リングセットクラスのセット関数を呼び出してキーを合わせる*/
+	return ringSet.KeySet(key_temp);
+  }
+        
+  /**
+   * それぞれのリングの現在のキーを求める
+   * @param [in] cursor リングの位置
+   * @return 大文字アルファベットN文字のキー(このキーでKeySetすると今と同じ位置になる)
+   */
+  std::string CurrentKey(const BasicRingCursor<N> &cursor) const{
+	int key_temp[N];
+	ringSet.CurrentKey(cursor, key_temp);
+	std::string key(N, 'A');
+	for(int i = 0; i < N; i++){
+	  key[i] = AlphaID2Alpha(key_temp[i]);
+	}
+	return key;
+  }
+        
+  /**
+   * @brief カーソルの位置で１文字暗号化する(スクランブラーは回さない)
+   * @param [in] cursor リングの位置
+   * @param [in] code アルファベットのID
+   * @return 換字されたアルファベットのID
+   */
+  inline int Encipher(const BasicRingCursor<N> &cursor, const int code) const{
+	int temp = code;
+	temp = plugboard.GoingEncipher(temp);
+	temp = ringSet.GoingEncipher(cursor, temp);
+	temp = reflector.Reflect(temp);
+	temp = ringSet.ReturningEncipher(cursor, temp);
+	temp = plugboard.ReturningEncipher(temp);
+	return temp;
+  }
+        
+  /**
+   * 暗号化(複号化)を行う
+   * @param [in,out] cursor リングの位置(暗号化した文字数だけ進む)
+   * @param [in] code この入力に対してEnigmaを実行する
+   * @return Enigmaによる変換後の文字列
+   */
+  std::string Encryption(BasicRingCursor<N> &cursor, const std::string &code) const{
+	std::string cryptogram(code.length(), ' ');
+	Encryption(cursor, code.data(), code.length(), &cryptogram[0]);
+	return cryptogram;
+  }
+        
+  /**
+   * 呼び出し側のバッファに暗号化(複号化)を行う
+   * @param [in,out] cursor リングの位置(暗号化した文字数だけ進む)
+   * @param [in] code この入力に対してEnigmaを実行する
+   * @param [in] length 文字数
+   * @param [out] cryptogram Enigmaによる変換後の文字列(length要素,codeと同じでもよい)
+   * @return なし
+   * @detail ヒープ領域を一切確保しないので,短いメッセージを大量に暗号化する場合に用いる
+   */
+  void Encryption(BasicRingCursor<N> &cursor, const char *code, const size_t length,
+				  char *cryptogram) const{
+	ENIGMA_COUNT(COUNTER_CHARS_ENCRYPTED, length);
+	/*一文字ずつIDに変換して暗号化（複号化）し,文字に戻す*/
+	for(size_t i = 0; i < length; i++){
+	  cryptogram[i] = AlphaID2Alpha(Encipher(cursor, Alpha2AlphaID(code[i])));
+	  cursor.EndCycle();
+	}
+  }
+        
+  /**
+   * 換字表を用いて暗号化(複号化)を行う
+   * @param [in,out] cursor リングの位置(暗号化した文字数だけ進む)
+   * @param [in] code この入力に対してEnigmaを実行する
+   * @return Enigmaによる変換後の文字列
+   * @detail 結果はEncryptionと同じ.1周期分の換字表を引くだけで各文字を変換する(3枚のときだけ)
+   */
+  std::string TableEncryption(BasicRingCursor<N> &cursor, const std::string &code) const{
+	std::shared_ptr<const SubstitutionTable> table = FindTable(cursor);
+            
+	/*現在の位置から換字表を引いて一文字ずつ変換する*/
+	std::string cryptogram(code.length(), ' ');
+	unsigned int pos = cursor.getOffset() % BasicRingSet<N>::PERIOD;
+	for(unsigned int i=0; i<code.length(); i++){
+	  cryptogram[i] = AlphaID2Alpha(table->Lookup(pos, Alpha2AlphaID(code[i])));
+	  if(++pos == BasicRingSet<N>::PERIOD){
+		pos = 0;
+	  }
+	}
+	ENIGMA_COUNT(COUNTER_CHARS_ENCRYPTED, code.length());
+	ENIGMA_COUNT(COUNTER_ROTOR_TURNOVERS, CountTurnovers(cursor.getOffset(), code.length()));
+	cursor.Advance(code.length());
+	return cryptogram;
+  }
+        
+  /**
+   * 一括暗号化カーネル(SIMD)を用いて暗号化(複号化)を行う
+   * @param [in,out] cursor リングの位置(暗号化した文字数だけ進む)
+   * @param [in] code この入力に対してEnigmaを実行する
+   * @param [in] kernel 使うカーネル(既定では実行中のCPUで使える最速のもの)
+   * @return Enigmaによる変換後の文字列
+   * @detail 結果はEncryptionと同じ.各レーンのスクランブラーの位置は位置から直接求める(3枚のときだけ)
+   */
+  std::string BatchEncryption(BasicRingCursor<N> &cursor, const std::string &code,
+							  const BatchKernel kernel = DetectBatchKernel()) const{
+	BatchTables tables;
+	ExportTables(cursor, tables);
+            
+	/*IDの列に変換してカーネルでまとめて変換し,文字列に戻す*/
+	std::vector<uint8_t> code_temp(code.length());
+	Alpha2AlphaID(code.data(), code.length(), code_temp.data());
+	BatchEncipher(tables, code_temp.data(), code_temp.data(), code.length(), cursor.getOffset(), kernel);
+	std::string cryptogram(code.length(), ' ');
+	AlphaID2Alpha(code_temp.data(), code_temp.size(), &cryptogram[0]);
+	ENIGMA_COUNT(COUNTER_CHARS_ENCRYPTED, code.length());
+	ENIGMA_COUNT(COUNTER_ROTOR_TURNOVERS, CountTurnovers(cursor.getOffset(), code.length()));
+	cursor.Advance(code.length());
+	return cryptogram;
+  }
+        
+  /**
+   * モードに応じたエンジン(換字表,一括暗号化カーネル,通常)で暗号化(複号化)を行う
+   * @param [in,out] cursor リングの位置(暗号化した文字数だけ進む)
+   * @param [in] code この入力に対してEnigmaを実行する
+   * @param [in] mode オプション(PERIOD_TABLE_MODE, BATCH_KERNEL_MODEを見る)
+   * @return Enigmaによる変換後の文字列
+   * @detail 3枚以外では,モードによらず1文字ずつ暗号化する
+   */
+  std::string EncryptionByMode(BasicRingCursor<N> &cursor, const std::string &code,
+							   const unsigned int mode) const{
+	return EncryptionByMode(cursor, code, mode, HasBatchTables());
+  }
+        
+  /**
+   * @brief IDの列をその場で暗号化(複号化)する
+   * @param [in,out] cursor リングの位置(暗号化した文字数だけ進む)
+   * @param [in,out] ids アルファベットのIDの列
+   * @param [in] length 文字数
+   * @return なし
+   * @detail 3枚なら一括暗号化カーネルで,それ以外の枚数では1文字ずつ暗号化する.ヒープ領域を確保しない
+   */
+  void EncipherIds(BasicRingCursor<N> &cursor, uint8_t *ids, const size_t length) const{
+	ENIGMA_COUNT(COUNTER_CHARS_ENCRYPTED, length);
+	EncipherIds(cursor, ids, length, HasBatchTables());
+  }
+        
+  /**
+   * @brief 一括暗号化カーネル用に全部品の表を書き出す
+   * @param [in] cursor キーを合わせたカーソル
+   * @param [out] tables 書き出し先
+   * @return なし
+   */
+  void ExportTables(const BasicRingCursor<N> &cursor, BatchTables &tables) const{
+	plugboard.ExportTables(tables.plugboard, tables.plugboardInverse);
+	ringSet.ExportTables(cursor, tables);
+	reflector.ExportTables(tables.reflector);
+  }
+        
+  /**
+   * @brief 1つの文字列を複数のキーで一度に暗号化(複号化)する
+   * @param [in] starts キーごとのキーを合わせた直後のring1~3の位置(RingCursor::getStartPos)
+   * @param [in] keys キーの数
+   * @param [in] ids 入力(アルファベットのID)
+   * @param [in] length 文字数
+   * @param [in] offset 先頭の文字がキーを合わせてから何文字目か
+   * @param [out] out 出力(アルファベットのID).i文字目のキーkの結果をout[i * keys + k]に置く
+   * @param [in] kernel 使うカーネル(既定では実行中のCPUで使える最速のもの)
+   * @return なし
+   * @detail 各キーの機械をSIMDのレーンに並べて同時に進める(MultiKeyEncipher)
+   */
+  void MultiKeyEncipher(const uint8_t (*starts)[3], const size_t keys, const uint8_t *ids,
+						const size_t length, const unsigned long long offset, uint8_t *out,
+						const BatchKernel kernel = DetectBatchKernel()) const{
+	BatchTables tables;
+	ExportTables(BasicRingCursor<N>(), tables);
+	::MultiKeyEncipher(tables, starts, keys, ids, length, offset, out, kernel);
+  }
+        
+  /**
+   * 1つの文字列を複数のキーで一度に暗号化(複号化)する
+   * @param [in] keys キー(それぞれ大文字アルファベット3文字)
+   * @param [in] code この入力に対してEnigmaを実行する
+   * @param [in] offset codeの先頭が,キーを合わせてから何文字目にあたるか
+   * @param [in] kernel 使うカーネル(既定では実行中のCPUで使える最速のもの)
+   * @return キーごとのEnigmaによる変換後の文字列(keysと同じ順)
+   */
+  std::vector<std::string> MultiKeyEncryption(const std::vector<std::string> &keys,
+											  const std::string &code,
+											  const unsigned long long offset = 0,
+											  const BatchKernel kernel = DetectBatchKernel()) const{
+	/*キーを合わせた直後の位置を並べる*/
+	std::vector<uint8_t> starts(keys.size() * 3);
+	for(size_t k = 0; k < keys.size(); k++){
+	  BasicRingCursor<N> cursor = KeySet(keys[k]);
+	  for(int r = 0; r < 3; r++){
+		starts[k * 3 + r] = cursor.getStartPos(r);
+	  }
+	}
+            
+	/*まとめて暗号化し,キーごとの文字列に並べ直す*/
+	std::vector<uint8_t> ids(code.length());
+	Alpha2AlphaID(code.data(), code.length(), ids.data());
+	std::vector<uint8_t> out(code.length() * keys.size());
+	MultiKeyEncipher((const uint8_t (*)[3])starts.data(), keys.size(), ids.data(), code.length(),
+					 offset, out.data(), kernel);
+	std::vector<std::string> cryptograms(keys.size(), std::string(code.length(), ' '));
+	for(size_t i = 0; i < code.length(); i++){
+	  for(size_t k = 0; k < keys.size(); k++){
+		cryptograms[k][i] = AlphaID2Alpha(out[i * keys.size() + k]);
+	  }
+	}
+	return cryptograms;
+  }
+        
+  /**
+   * @brief カーソルの位置で１文字暗号化し,各部品を通った後のIDを記録する(スクランブラーは回さない)
+   * @param [in] cursor リングの位置
+   * @param [in] code アルファベットのID
+   * @param [out] record 1文字分のトレース
+   * @return 換字されたアルファベットのID
+   */
+  inline int TraceEncipher(const BasicRingCursor<N> &cursor, const int code, TraceRecord &record) const{
+	for(int i = 0; i < 3; i++){
+	  record.pos[i] = cursor.getPos(i);
+	}
+	record.ids[0] = code;
+	record.ids[1] = plugboard.GoingEncipher(code);
+	ringSet.TraceGoingEncipher(cursor, record.ids[1], &record.ids[2]);
+	record.ids[5] = reflector.Reflect(record.ids[4]);
+	ringSet.TraceReturningEncipher(cursor, record.ids[5], &record.ids[6]);
+	record.ids[9] = plugboard.ReturningEncipher(record.ids[8]);
+	return record.ids[9];
+  }
+        
+  /**
+   * @brief トレースのヘッダを作る
+   * @param [in] cursor リングの位置(メッセージの先頭の文字の位置)
+   * @param [in] kind 表示の種類
+   * @param [in] window 記録する文字の位置
+   * @param [out] header 作ったヘッダ
+   * @return なし
+   */
+  void MakeTraceHeader(const BasicRingCursor<N> &cursor, const TraceKind kind, const TraceWindow &window,
+					   TraceHeader &header) const{
+	BatchTables tables;
+	ExportTables(cursor, tables);
+	::MakeTraceHeader(tables, kind, cursor.getOffset(), window, header);
+  }
+        
+  /**
+   * @brief メッセージの一部のうち記録する位置の文字をたどり,トレースに記録する
+   * @param [in] start codeの先頭の文字の位置に合わせたカーソル
+   * @param [in] code メッセージの一部(暗号化する前の入力)
+   * @param [in] base codeの先頭がメッセージの何文字目か(0から数える)
+   * @param [in] window 記録する文字の位置(メッセージの先頭から数える)
+   * @param [in] writer トレースの書き出し先(NULLなら-t/-kの形式で標準出力に表示する)
+   * @param [in,out] renderer 表示に使う(Beginの後,Endの前に呼ぶ)
+   * @return なし
+   * @detail 記録する文字だけをその位置にSeekしたカーソルでたどってレコードにする.
+   *         レコードはTRACE_BLOCK個ずつファイルに書き出すか,文字列にして表示する.
+   *         メッセージをブロックに分けて順に渡せば,全体を一度に渡した場合と同じトレースになる
+   */
+  void TraceBlock(const BasicRingCursor<N> &start, const std::string &code, const unsigned long long base,
+				  const TraceWindow &window, TraceWriter *writer, TraceRenderer &renderer) const{
+	/*このブロックで最初に記録する位置を求める(間隔を足すと桁あふれする場合は記録しない)*/
+	unsigned long long end = std::min<unsigned long long>(window.to, base + code.length());
+	unsigned long long pos = window.from;
+	bool more = pos < end;
+	if(pos < base){
+	  unsigned long long skip = (window.every - (base - pos) % window.every) % window.every;
+	  more = base < end && skip < end - base;
+	  pos = base + (more ? skip : 0);
+	}
+            
+	/*記録する位置に直接合わせてブロックごとに記録し,書き出すか表示する*/
+	TraceRecord records[TRACE_BLOCK];
+	BasicRingCursor<N> sample = start;
+	std::string text = "";
+	while(more){
+	  size_t count = 0;
+	  for(; count < TRACE_BLOCK && more; count++){
+		sample.Seek(start.getOffset() + (pos - base));
+		TraceEncipher(sample, Alpha2AlphaID(code[pos - base]), records[count]);
+		/*間隔を足すと桁あふれする場合も,次の位置がend以上になるので終える*/
+		more = window.every < end - pos;
+		pos += more ? window.every : 0;
+	  }
+	  if(writer != NULL){
+		writer->Write(records, count);
+	  }else{
+		renderer.Render(records, count, text);
+		std::cout.write(text.data(), text.length());
+		text.clear();
+	  }
+	}
+  }
+        
+  /**
+   * 暗号化(複号化)を行い,変換経過をトレースに記録する
+   * @param [in,out] cursor リングの位置(暗号化した文字数だけ進む)
+   * @param [in] code この入力に対してEnigmaを実行する
+   * @param [in] kind 表示の種類(-tなら変換経過だけ,-kなら毎回のキー配列も)
+   * @param [in] window 記録する文字の位置
+   * @param [in] writer トレースの書き出し先(NULLなら-t/-kの形式で標準出力に表示する)
+   * @return Enigmaによる変換後の文字列
+   * @detail メッセージ全体は一括暗号化カーネルで暗号化し,記録する文字はTraceBlockでたどる
+   */
+  std::string TraceEncryption(BasicRingCursor<N> &cursor, const std::string &code, const TraceKind kind,
+							  const TraceWindow &window, TraceWriter *writer) const{
+	TraceHeader header;
+	MakeTraceHeader(cursor, kind, window, header);
+	TraceRenderer renderer(header, kind == TRACE_KEY_ARRAY);
+	std::string text = "";
+	if(writer == NULL){
+	  renderer.Begin(text);
+	  std::cout.write(text.data(), text.length());
+	  text.clear();
+	}
+	BasicRingCursor<N> start = cursor;
+	std::string cryptogram = BatchEncryption(cursor, code);
+	TraceBlock(start, code, 0, window, writer, renderer);
+	if(writer == NULL){
+	  renderer.End(text);
+	  std::cout.write(text.data(), text.length());
+	  std::cout.flush();
+	}
+	return cryptogram;
+  }
+        
+  /**
+   * 暗号化(複号化)と変換経過の表示を行う
+   * @param [in,out] cursor リングの位置(暗号化した文字数だけ進む)
+   * @param [in] code この入力に対してEnigmaを実行する
+   * @param [in] window 表示する文字の位置(既定ではすべて)
+   * @return Enigmaによる変換後の文字列
+   */
+  std::string VisibleEncryption(BasicRingCursor<N> &cursor, const std::string &code,
+								const TraceWindow &window = TraceWindow()) const{
+	return TraceEncryption(cursor, code, TRACE_TRANSITION, window, NULL);
+  }
+        
+  /**
+   * 暗号化(複号化)と毎回のキー配列・変換経過の表示を行う
+   * @param [in,out] cursor リングの位置(暗号化した文字数だけ進む)
+   * @param [in] code この入力に対してEnigmaを実行する
+   * @param [in] window 表示する文字の位置(既定ではすべて)
+   * @return Enigmaによる変換後の文字列
+   */
+  std::string KeyVisibleEncryption(BasicRingCursor<N> &cursor, const std::string &code,
+								   const TraceWindow &window = TraceWindow()) const{
+	return TraceEncryption(cursor, code, TRACE_KEY_ARRAY, window, NULL);
+  }
+        
+  /**
+   * @brief キー配列を表示する
+   * @param [in] cursor リングの位置
+   * @return なし
+   */
+  void ShowKeyArray(const BasicRingCursor<N> &cursor) const{
+	std::cout << "\t            [ A B C D E F G H I J K L M N O P Q R S T U V W X Y Z ]" << std::endl;
+	std::cout << "\t              | | | | | | | | | | | | | | | | | | | | | | | | | |  " << std::endl;
+	plugboard.ShowKeyArray();
+	ringSet.ShowKeyArray(cursor);
+	reflector.ShowKeyArray();
+  }
+};
+
+//3枚のリングの配線(キーが3文字のとき.攻撃やセッションはこの配線を使う)
+typedef BasicEnigmaConfig<3> EnigmaConfig;
+
+/**
+ * @class EnigmaSession
+ * @brief 1つのメッセージを分割して少しずつ暗号化(複号化)するためのセッション
+ * @detail Initでキーを合わせ,届いた分からUpdateで暗号化する.リングの位置はUpdateを
+ *         またいで引き継ぐので,結果は全体を一度に暗号化した場合と同じになる.
+ *         配線は共有のEnigmaConfigを参照するだけなので,セッションは軽い
+ */
+class EnigmaSession{
+private:
+  const EnigmaConfig *config; //配線(セッションより長く生存していること)
+  RingCursor cursor;          //キーと現在の位置
+  unsigned long long initialOffset = 0; //Initで合わせた位置
+public:
+  /**
+   * コンストラクタ
+   * @param [in] config 配線
+   */
+  explicit EnigmaSession(const EnigmaConfig &config) : config(&config), cursor(){
+  }
+        
+  /**
+   * キーを合わせてメッセージの暗号化を始める
+   * @param [in] key キーが大文字アルファベット3文字で与えられる
+   * @param [in] offset メッセージの先頭が,キーを合わせてから何文字目にあたるか
+   * @return なし
+   */
+  void Init(const std::string key, const unsigned long long offset = 0){
+	cursor = config->KeySet(key);
+	cursor.Seek(offset);
+	initialOffset = offset;
+  }
+        
+  /**
+   * メッセージの続きを暗号化(複号化)する(ヒープ領域を確保しない)
+   * @param [in] chunk メッセージの続き
+   * @param [in] length 文字数
+   * @param [out] cryptogram 変換後の文字列(length要素,chunkと同じでもよい)
+   * @return なし
+   */
+  void Update(const char *chunk, const size_t length, char *cryptogram){
+	config->Encryption(cursor, chunk, length, cryptogram);
+  }
+        
+  /**
+   * メッセージの続きを暗号化(複号化)する
+   * @param [in] chunk メッセージの続き
+   * @return 変換後の文字列
+   */
+  std::string Update(const std::string &chunk){
+	return config->Encryption(cursor, chunk);
+  }
+        
+  /**
+   * メッセージを終え,Initの直後の状態に戻す
+   * @param なし
+   * @return このメッセージで暗号化した文字数
+   * @detail 同じキーで次のメッセージを暗号化するときは,そのままUpdateしてよい
+   */
+  unsigned long long Final(){
+	unsigned long long length = cursor.getOffset() - initialOffset;
+	cursor.Seek(initialOffset);
+	return length;
+  }
+        
+  /**
+   * @brief 現在の位置を返す
+   * @param なし
+   * @return キーを合わせてから暗号化した文字数
+   */
+  inline unsigned long long getOffset() const{
+	return cursor.getOffset();
+  }
+        
+  /**
+   * @brief 現在の状態を返す
+   * @param なし
+   * @return それぞれのリングのキー(大文字アルファベット3文字)
+   */
+  inline std::string getState() const{
+	return config->CurrentKey(cursor);
+  }
+        
+  /**
+   * @brief cursorに対するgetアクセサ
+   * @param なし
+   * @return キーと現在の位置(複製すれば状態を退避できる)
+   */
+  inline const RingCursor &getCursor() const{
+	return cursor;
+  }
+};
+
+/**
+ * @class BasicEnigma
+ * @brief プログラムの中枢を実装
+ * @tparam N リングの枚数(MIN_ROTORS~MAX_ROTORS.-sのキーの文字数で選ぶ)
+ * @detail 配線(BasicEnigmaConfig)とカーソル(BasicRingCursor)を1組にまとめたもの.暗号化すると
+ *         カーソルが進むので,暗号化の関数はconstではない.状態はすべてuint8_tの配列と
+ *         位置だけで持ち,ポインタを含まないのでmemcpyでそのまま複製・退避・復元できる
+ */
+template<int N>
+class BasicEnigma{
+private:
+  BasicEnigmaConfig<N> config;
+  BasicRingCursor<N> cursor;
+        
+  //ブロックごとに呼ぶ変換経過の記録(ブロックの先頭の位置のカーソルと,暗号化する前の入力を受け取る)
+  typedef std::function<void(const BasicRingCursor<N> &, const std::string &)> BlockTrace;
+        
+  /**
+   * @brief バッファの内容をすべて書き出す
+   * @param [in] fd 出力のファイル記述子
+   * @param [in] buf 書き出す内容
+   * @param [in] length バイト数
+   * @return 終了ステータス
+   */
+  static int WriteAll(const int fd, const char *buf, size_t length){
+	while(length > 0){
+	  ssize_t n = write(fd, buf, length);
+	  if(n < 0){
+		if(errno == EINTR){
+		  continue;
+		}
+		std::cerr << "\tCannot write the output." << std::endl;
+		return -1;
+	  }
+	  buf += n;
+	  length -= n;
+	}
+	return 0;
+  }
+        
+  /**
+   * 変換経過をバイナリトレースに記録するか,標準出力に表示しながら暗号化(複号化)する(3枚のとき)
+   * @param [in] arguments 引数情報を格納しているオブジェクト
+   * @param [out] cryptogram Enigmaによる変換後の文字列(-oで書き出したときは空)
+   * @return 終了ステータス
+   * @detail -Tがあればトレースに記録し,なければ-t/-kの形式で表示する.
+   *         -f/-oではStreamExecuteでブロックごとに暗号化し,記録する位置の文字もブロックごとに記録する
+   */
+  int TraceExecute(const Arguments &arguments, std::string &cryptogram, std::true_type){
+	unsigned int mode = arguments.getMode();
+	TraceKind kind = (mode & SHOW_KEY_ARRAY_MODE) ? TRACE_KEY_ARRAY : TRACE_TRANSITION;
+	TraceWindow window(arguments.getTraceFrom(), arguments.getTraceTo(), arguments.getTraceEvery());
+	TraceHeader header;
+	config.MakeTraceHeader(cursor, kind, window, header);
+	TraceWriter writer;
+	TraceWriter *records = NULL; //NULLなら表示する
+	if(mode & TRACE_FILE_MODE){
+	  if(writer.Open(arguments.getTraceFile(), header) < 0){
+		return -1;
+	  }
+	  records = &writer;
+	}
+	cryptogram = "";
+	int status = 0;
+	if((mode & READ_FILE_MODE) && (mode & OUT_FILE_MODE)){
+	  unsigned long long start = cursor.getOffset();
+	  TraceRenderer renderer(header, kind == TRACE_KEY_ARRAY);
+	  std::string text = "";
+	  if(records == NULL){
+		renderer.Begin(text);
+		std::cout.write(text.data(), text.length());
+		text.clear();
+	  }
+	  status = StreamExecute(arguments, [&](const BasicRingCursor<N> &block, const std::string &code){
+		config.TraceBlock(block, code, block.getOffset() - start, window, records, renderer);
+	  });
+	  if(records == NULL){
+		renderer.End(text);
+		std::cout.write(text.data(), text.length());
+		std::cout.flush();
+	  }
+	}else{
+	  std::string result = "";
+	  {
+		ENIGMA_STAGE(STAGE_ENCRYPT);
+		result = config.TraceEncryption(cursor, arguments.getCode(), kind, window, records);
+	  }
+	  if(mode & OUT_FILE_MODE){
+		status = WriteOutFile(arguments, result);
+	  }else{
+		cryptogram = result;
+	  }
+	}
+	if(records != NULL && writer.Close() < 0){
+	  return -1;
+	}
+	return status;
+  }
+        
+  /**
+   * 変換経過を記録・表示する(3枚以外のとき.トレースは3枚の形式なので記録も表示もできない)
+   * @return 終了ステータス(常に-1)
+   */
+  int TraceExecute(const Arguments &, std::string &, std::false_type){
+	std::cerr << "\t-t, -k and -T can be used only with 3 rotors." << std::endl;
+	return -1;
+  }
+public:
+  /**
+   * デフォルトコンストラクタ
+   */
+  BasicEnigma() : config(), cursor(){
+  }
+        
+  /**
+   * コンストラクタ
+   * @param [in] config 配線
+   */
+  explicit BasicEnigma(const BasicEnigmaConfig<N> &config) : config(config), cursor(){
+  }
+        
+  /**
+   * それぞれのリングにキーを設定する
+   * @param [in] key キーが大文字アルファベットN文字で与えられる
+   * @return なし
+   */
+  void KeySet(const std::string key){
+	cursor = config.KeySet(key);
+  }
+        
+  /**
+   * キーを合わせてからoffset文字暗号化した後の状態に直接合わせる
+   * @param [in] offset キーを合わせてからの文字数
+   * @return なし
+   */
+  void Seek(const unsigned long long offset){
+	cursor.Seek(offset);
+  }
+        
+  /**
+   * @brief configに対するgetアクセサ
+   * @param なし
+   * @return 配線(複数のスレッドで共有してよい)
+   */
+  inline const BasicEnigmaConfig<N> &getConfig() const{
+	return config;
+  }
+        
+  /**
+   * @brief cursorに対するgetアクセサ
+   * @param なし
+   * @return キーと現在の位置
+   */
+  inline const BasicRingCursor<N> &getCursor() const{
+	return cursor;
+  }
+        
+  /**
+   * @brief 現在の位置を返す
+   * @param なし
+   * @return キーを合わせてから暗号化した文字数
+   */
+  inline unsigned long long getOffset() const{
+	return cursor.getOffset();
+  }
+        
+  /**
+   * @brief 現在の状態を返す
+   * @param なし
+   * @return それぞれのリングのキー(大文字アルファベットN文字)
+   */
+  inline std::string getState() const{
+	return config.CurrentKey(cursor);
+  }
+        
+  /**
+   * @brief 現在のキーの位置で１文字暗号化する(スクランブラーは回さない)
+   * @param [in] code アルファベットのID
+   * @return 換字されたアルファベットのID
+   */
+  inline int Encipher(const int code) const{
+	return config.Encipher(cursor, code);
+  }
+        
+  /**
+   * 暗号化(複号化)を行う
+   * @param [in] code この入力に対してEnigmaを実行する
+   * @return Enigmaによる変換後の文字列
+   */
+  std::string Encryption(const std::string code){
+	return config.Encryption(cursor, code);
+  }
+        
+  /**
+   * 呼び出し側のバッファに暗号化(複号化)を行う(ヒープ領域を確保しない)
+   * @param [in] code この入力に対してEnigmaを実行する
+   * @param [in] length 文字数
+   * @param [out] cryptogram Enigmaによる変換後の文字列(length要素,codeと同じでもよい)
+   * @return なし
+   */
+  void Encryption(const char *code, const size_t length, char *cryptogram){
+	config.Encryption(cursor, code, length, cryptogram);
+  }
+        
+  /**
+   * 指定の位置から暗号化(複号化)を行う
+   * @param [in] code この入力に対してEnigmaを実行する
+   * @param [in] offset codeの先頭が,キーを合わせてから何文字目にあたるか
+   * @return Enigmaによる変換後の文字列
+   * @detail 長い暗号文の途中からの一部分だけを,先頭から辿らずに複号化できる
+   */
+  std::string Encryption(const std::string code, const unsigned long long offset){
+	Seek(offset);
+	return Encryption(code);
+  }
+        
+  /**
+   * 換字表を用いて暗号化(複号化)を行う
+   * @param [in] code この入力に対してEnigmaを実行する
+   * @return Enigmaによる変換後の文字列
+   */
+  std::string TableEncryption(const std::string code){
+	return config.TableEncryption(cursor, code);
+  }
+        
+  /**
+   * 一括暗号化カーネル(SIMD)を用いて暗号化(複号化)を行う
+   * @param [in] code この入力に対してEnigmaを実行する
+   * @param [in] kernel 使うカーネル(既定では実行中のCPUで使える最速のもの)
+   * @return Enigmaによる変換後の文字列
+   */
+  std::string BatchEncryption(const std::string code,
+							  const BatchKernel kernel = DetectBatchKernel()){
+	return config.BatchEncryption(cursor, code, kernel);
+  }
+        
+  /**
+   * @brief 一括暗号化カーネル用に全部品の表を書き出す
+   * @param [out] tables 書き出し先
+   * @return なし
+   */
+  void ExportTables(BatchTables &tables) const{
+	config.ExportTables(cursor, tables);
+  }
+        
+  /**
+   * 暗号化(複号化)と変換経過の表示を行う
+   * @param [in] code この入力に対してEnigmaを実行する
+   * @param [in] window 表示する文字の位置(既定ではすべて)
+   * @return Enigmaによる変換後の文字列
+   */
+  std::string VisibleEncryption(const std::string code, const TraceWindow &window = TraceWindow()){
+	return config.VisibleEncryption(cursor, code, window);
+  }
+        
+  /**
+   * 暗号化(複号化)と毎回のキー配列・変換経過の表示を行う
+   * @param [in] code この入力に対してEnigmaを実行する
+   * @param [in] window 表示する文字の位置(既定ではすべて)
+   * @return Enigmaによる変換後の文字列
+   */
+  std::string KeyVisibleEncryption(const std::string code, const TraceWindow &window = TraceWindow()){
+	return config.KeyVisibleEncryption(cursor, code, window);
+  }
+        
+  /**
+   * @brief キー配列を表示する
+   * @param なし
+   * @return なし
+   */
+  void ShowKeyArray() const{
+	config.ShowKeyArray(cursor);
+  }
+        
+  /**
+   * モードに応じたエンジン(換字表,一括暗号化カーネル,通常)で暗号化(複号化)を行う
+   * @param [in] code この入力に対してEnigmaを実行する
+   * @param [in] mode オプション(PERIOD_TABLE_MODE, BATCH_KERNEL_MODEを見る)
+   * @return Enigmaによる変換後の文字列
+   */
+  std::string EncryptionByMode(const std::string code, const unsigned int mode){
+	return config.EncryptionByMode(cursor, code, mode);
+  }
+        
+  /**
+   * 入力を分割し,複数のスレッドで暗号化(複号化)を行う
+   * @param [in] code この入力に対してEnigmaを実行する
+   * @param [in] jobs スレッド数
+   * @param [in] mode オプション(エンジンの選択に用いる)
+   * @return Enigmaによる変換後の文字列(EncryptionByModeと同じ)
+   * @detail 各スレッドは配線を共有し,自分のカーソルを担当部分の先頭の位置にSeekしてから暗号化する.
+   *         分割が細かすぎないよう,1スレッドあたり最低MIN_CHUNK文字を受け持たせる
+   */
+  std::string ParallelEncryption(const std::string code, const unsigned int jobs,
+								 const unsigned int mode){
+	static const size_t MIN_CHUNK = 1 << 16;
+	size_t workers = std::min<size_t>(jobs, code.length() / MIN_CHUNK);
+	if(workers <= 1){
+	  return EncryptionByMode(code, mode);
+	}
+            
+	/*担当部分ごとにカーソルの位置を合わせて並列に暗号化し,結果を順番通りに書き込む*/
+	std::string cryptogram(code.length(), ' ');
+	std::vector<std::thread> threads;
+	const BasicEnigmaConfig<N> *shared = &config;
+	unsigned long long start = cursor.getOffset();
+	for(size_t i = 0; i < workers; i++){
+	  size_t begin = code.length() * i / workers;
+	  size_t end = code.length() * (i + 1) / workers;
+	  BasicRingCursor<N> worker = cursor;
+	  threads.push_back(std::thread([=, &code, &cryptogram]() mutable{
+		worker.Seek(start + begin);
+		std::string part = shared->EncryptionByMode(worker, code.substr(begin, end - begin), mode);
+		std::copy(part.begin(), part.end(), cryptogram.begin() + begin);
+	  }));
+	}
+	for(size_t i = 0; i < workers; i++){
+	  threads[i].join();
+	}
+	cursor.Advance(code.length());
+	return cryptogram;
+  }
+        
+  /**
+   * 入力ストリームをブロックごとに暗号化(複号化)し,出力ストリームに書き出す
+   * @param [in] in 入力ストリーム
+   * @param [out] out 出力ストリーム
+   * @param [in] jobs スレッド数
+   * @param [in] mode オプション(エンジンの選択に用いる)
+   * @param [in] trace ブロックを暗号化するたびに呼ぶ変換経過の記録(空なら記録しない)
+   * @return 終了ステータス(数字が含まれているか,書き出しに失敗すれば-1)
+   * @detail スクランブラーの状態はブロックをまたいで引き継ぐので,結果は全体を一度に
+   *         暗号化した場合と同じ.メモリ使用量は入力の大きさによらずBLOCK_SIZE程度に収まる
+   */
+  int StreamEncryption(std::istream &in, std::ostream &out, const unsigned int jobs,
+					   const unsigned int mode, const BlockTrace &trace = BlockTrace()){
+	static const size_t BLOCK_SIZE = 1 << 20;
+	std::vector<char> buf(BLOCK_SIZE);
+	std::string code = "";
+	code.reserve(BLOCK_SIZE);
+	while(in){
+	  {
+		ENIGMA_STAGE(STAGE_READ);
+		in.read(&buf[0], BLOCK_SIZE);
+		ENIGMA_COUNT(COUNTER_BYTES_READ, in.gcount());
+		if(!NormalizeBlock(&buf[0], in.gcount(), code)){
+		  std::cerr << "\tArguments should be letters!" << std::endl;
+		  return -1;
+		}
+	  }
+	  std::string cryptogram = "";
+	  {
+		ENIGMA_STAGE(STAGE_ENCRYPT);
+		BasicRingCursor<N> start = cursor;
+		cryptogram = ParallelEncryption(code, jobs, mode);
+		if(trace){
+		  trace(start, code);
+		}
+	  }
+	  ENIGMA_STAGE(STAGE_WRITE);
+	  out.write(cryptogram.data(), cryptogram.length());
+	  if(out.fail()){
+		std::cerr << "\tCannot write the output." << std::endl;
+		return -1;
+	  }
+	  ENIGMA_COUNT(COUNTER_BYTES_WRITTEN, cryptogram.length());
+	}
+	return 0;
+  }
+        
+  /**
+   * 入力ファイルを逐次読み込んで暗号化(複号化)し,出力ファイルに書き出す
+   * @param [in] arguments 引数情報を格納しているオブジェクト
+   * @param [in] trace ブロックを暗号化するたびに呼ぶ変換経過の記録(空なら記録しない)
+   * @return 終了ステータス(出力ファイルを開けない・書き込めない場合も-1)
+   * @detail 入力に数字が含まれていた場合は,書きかけの出力ファイルを削除する(書き出しに失敗した場合は消さない)
+   */
+  int StreamExecute(const Arguments &arguments, const BlockTrace &trace = BlockTrace()){
+	std::ifstream ifs(arguments.getInFileName(), std::ios::binary);
+	if(ifs.fail()){
+	  std::cerr << "\tFile cannot open. > " << arguments.getInFileName() << std::endl;
+	  return -1;
+	}
+	std::ofstream ofs(arguments.getOutFileName(), std::ios::binary);
+	if(ofs.fail()){
+	  std::cerr << "\tFile cannot open. > " << arguments.getOutFileName() << std::endl;
+	  return -1;
+	}
+	if(StreamEncryption(ifs, ofs, arguments.getJobs(), arguments.getMode(), trace) < 0){
+	  /*書き出しに失敗したのでなければ(入力の誤りなら)書きかけのファイルを消す*/
+	  if(!ofs.fail()){
+		ofs.close();
+		std::remove(arguments.getOutFileName().c_str());
+	  }
+	  return -1;
+	}
+	ofs << std::endl;
+	ofs.close();
+	if(ofs.fail()){
+	  std::cerr << "\tCannot write the output. > " << arguments.getOutFileName() << std::endl;
+	  return -1;
+	}
+	return 0;
+  }
+        
+  /**
+   * 入力を暗号化(複号化)し,結果だけを出力に書き出す(フィルタ)
+   * @param [in] in_fd 入力のファイル記述子
+   * @param [in] out_fd 出力のファイル記述子
+   * @return 終了ステータス
+   * @detail 固定長のバッファと一括暗号化カーネル(3枚のとき)だけを用い,ヒープ領域を一切確保しない.
+   *         入力は-fと同じく空白と改行を除いて大文字に変換し,最後に改行を出力する
+   */
+  int FilterExecute(const int in_fd, const int out_fd){
+	static const size_t FILTER_BLOCK_SIZE = 1 << 16;
+	char buf[FILTER_BLOCK_SIZE];
+	uint8_t *ids = (uint8_t *)buf; //IDへの変換はbufの上でそのまま行う
+            
+	ssize_t n = 0;
+	while(true){
+	  size_t length = 0;
+	  {
+		ENIGMA_STAGE(STAGE_READ);
+		if((n = read(in_fd, buf, FILTER_BLOCK_SIZE)) == 0){
+		  break;
+		}
+		if(n < 0){
+		  if(errno == EINTR){
+			continue;
+		  }
+		  std::cerr << "\tCannot read the input." << std::endl;
+		  return -1;
+		}
+		ENIGMA_COUNT(COUNTER_BYTES_READ, n);
+                
+		/*空白と改行を除き,大文字にしてIDに変換する*/
+		for(ssize_t i = 0; i < n; i++){
+		  char c = buf[i];
+		  if(c == ' ' || c == '\n'){
+			continue;
+		  }
+		  if(isdigit(c)){
+			std::cerr << "\tArguments should be letters!" << std::endl;
+			return -1;
+		  }
+		  ids[length++] = Alpha2AlphaID(toupper(c));
+		}
+	  }
+                
+	  /*まとめて暗号化し,文字に戻して書き出す*/
+	  {
+		ENIGMA_STAGE(STAGE_ENCRYPT);
+		config.EncipherIds(cursor, ids, length);
+		AlphaID2Alpha(ids, length, buf);
+	  }
+	  ENIGMA_STAGE(STAGE_WRITE);
+	  if(WriteAll(out_fd, buf, length) < 0){
+		return -1;
+	  }
+	  ENIGMA_COUNT(COUNTER_BYTES_WRITTEN, length);
+	}
+	return WriteAll(out_fd, "\n", 1);
+  }
+        
+  /**
+   * (キー,メッセージ)の組を1行に1つずつ読み込み,それぞれ暗号化(複号化)した結果を1行ずつ書き出す
+   * @param [in] in ジョブの入力ストリーム("KEY MESSAGE"の行,空行は読み飛ばす)
+   * @param [out] out 出力ストリーム(ジョブの順に1行ずつ)
+   * @param [in] jobs スレッド数
+   * @param [in] mode オプション(エンジンの選択に用いる)
+   * @return 終了ステータス(不正な行があれば-1.その行の結果は空行になる)
+   * @detail 構築済みの配線を使い回し,ジョブごとにKeySetでキーを合わせ直すだけで暗号化する.
+   *         メッセージはそれぞれ現在の位置(-n)から暗号化する.ジョブはBLOCK_JOBS行ずつ読み,
+   *         複数のスレッドが小分けにして取り合って処理する.換字表(-p)は1周期分より短い
+   *         メッセージでは作る方が高くつき,キーごとに作ると大量のメモリを使うので,
+   *         周期以上の長さのメッセージだけに使う
+   */
+  int BatchJobEncryption(std::istream &in, std::ostream &out, const unsigned int jobs,
+						 const unsigned int mode){
+	static const size_t BLOCK_JOBS = 1 << 14;
+	static const size_t GRAIN = 64;
+	unsigned long long start = cursor.getOffset();
+	unsigned long long line_number = 0;
+	int status = 0;
+	std::vector<std::string> keys(BLOCK_JOBS), codes(BLOCK_JOBS), results(BLOCK_JOBS);
+	std::vector<char> valid(BLOCK_JOBS);
+	std::vector<BasicEnigma> machines(std::max(1u, jobs), *this);
+	std::string line = "";
+	while(in){
+	  /*ジョブを1ブロック分読み込む*/
+	  size_t count = 0;
+	  {
+		ENIGMA_STAGE(STAGE_READ);
+		while(count < BLOCK_JOBS && getline(in, line)){
+		  ENIGMA_COUNT(COUNTER_BYTES_READ, line.length() + 1);
+		  line_number++;
+		  if(!line.empty() && line[line.length() - 1] == '\r'){
+			line.erase(line.length() - 1);
+		  }
+		  if(line.empty()){
+			continue;
+		  }
+		  valid[count] = ParseJob(line, keys[count], codes[count], N);
+		  if(!valid[count]){
+			std::cerr << "\tLine " << line_number << ": invalid job > " << line << std::endl;
+			status = -1;
+		  }
+		  count++;
+		}
+	  }
+                
+	  /*各スレッドがGRAIN件ずつジョブを取り,自分のエニグマのキーを合わせ直して暗号化する*/
+	  std::atomic<size_t> next(0);
+	  std::function<void(BasicEnigma *)> work = [&](BasicEnigma *machine){
+		size_t begin = 0;
+		while((begin = next.fetch_add(GRAIN)) < count){
+		  for(size_t i = begin; i < std::min(begin + GRAIN, count); i++){
+			if(!valid[i]){
+			  results[i].clear();
+			  continue;
+			}
+			machine->KeySet(keys[i]);
+			machine->Seek(start);
+			unsigned int job_mode = (codes[i].length() < BasicRingSet<N>::PERIOD) ? (mode & ~PERIOD_TABLE_MODE) : mode;
+			results[i] = machine->EncryptionByMode(codes[i], job_mode);
+		  }
+		}
+	  };
+	  {
+		ENIGMA_STAGE(STAGE_ENCRYPT);
+		size_t workers = std::min<size_t>(machines.size(), (count + GRAIN - 1) / GRAIN);
+		std::vector<std::thread> threads;
+		for(size_t i = 1; i < workers; i++){
+		  threads.push_back(std::thread(work, &machines[i]));
+		}
+		work(&machines[0]);
+		for(size_t i = 0; i < threads.size(); i++){
+		  threads[i].join();
+		}
+	  }
+                
+	  /*ジョブの順に書き出す*/
+	  ENIGMA_STAGE(STAGE_WRITE);
+	  for(size_t i = 0; i < count; i++){
+		out << results[i] << '\n';
+		ENIGMA_COUNT(COUNTER_BYTES_WRITTEN, results[i].length() + 1);
+	  }
+	}
+	out.flush();
+	return status;
+  }
+        
+  /**
+   * ジョブファイル(-b)の(キー,メッセージ)をまとめて暗号化(複号化)する
+   * @param [in] arguments 引数情報を格納しているオブジェクト
+   * @return 終了ステータス(出力を開けない・書き込めない場合も-1)
+   * @detail ジョブファイルが"-"なら標準入力から読む.-oがなければ標準出力に書き出す
+   */
+  int BatchJobExecute(const Arguments &arguments){
+	std::ifstream ifs;
+	std::istream *in = &std::cin;
+	if(arguments.getInFileName() != "-"){
+	  ifs.open(arguments.getInFileName(), std::ios::binary);
+	  if(ifs.fail()){
+		std::cerr << "\tFile cannot open. > " << arguments.getInFileName() << std::endl;
+		return -1;
+	  }
+	  in = &ifs;
+	}
+	std::ofstream ofs;
+	std::ostream *out = &std::cout;
+	if(arguments.getMode() & OUT_FILE_MODE){
+	  ofs.open(arguments.getOutFileName(), std::ios::binary);
+	  if(ofs.fail()){
+		std::cerr << "\tFile cannot open. > " << arguments.getOutFileName() << std::endl;
+		return -1;
+	  }
+	  out = &ofs;
+	}
+	int status = BatchJobEncryption(*in, *out, arguments.getJobs(), arguments.getMode());
+	if(ofs.is_open()){
+	  ofs.close();
+	}
+	if(out->fail()){
+	  std::cerr << "\tCannot write the output." << std::endl;
+	  return -1;
+	}
+	return status;
+  }
+        
+  /**
+   * 変換経過を表示(-t/-k)するか,表示する代わりにバイナリトレースに記録(-T)しながら暗号化(複号化)する
+   * @param [in] arguments 引数情報を格納しているオブジェクト
+   * @param [out] cryptogram Enigmaによる変換後の文字列(-oで書き出したときは空)
+   * @return 終了ステータス
+   * @detail -kがあれば毎回のキー配列も,なければ変換経過だけを表示(記録)する.
+   *         -R/-Eがあればその位置の文字だけを表示(記録)する.-oがあれば結果はファイルに書き出す.
+   *         記録したトレースはenigma_traceで-t/-kと同じ形式に表示できる(3枚のときだけ)
+   */
+  int TraceExecute(const Arguments &arguments, std::string &cryptogram){
+	return TraceExecute(arguments, cryptogram, typename BasicEnigmaConfig<N>::HasBatchTables());
+  }
+        
+  /**
+   * 変換後の文字列を出力ファイル(-o)に書き出す
+   * @param [in] arguments 引数情報を格納しているオブジェクト
+   * @param [in] cryptogram Enigmaによる変換後の文字列
+   * @return 終了ステータス(出力ファイルを開けない・書き込めない場合は-1)
+   */
+  static int WriteOutFile(const Arguments &arguments, const std::string &cryptogram){
+	ENIGMA_STAGE(STAGE_WRITE);
+	std::ofstream ofs(arguments.getOutFileName());
+	if(ofs.fail()){
+	  std::cerr << "\tFile cannot open. > " << arguments.getOutFileName() << std::endl;
+	  return -1;
+	}
+	ofs << cryptogram << std::endl;
+	ofs.close();
+	if(ofs.fail()){
+	  std::cerr << "\tCannot write the output. > " << arguments.getOutFileName() << std::endl;
+	  return -1;
+	}
+	ENIGMA_COUNT(COUNTER_BYTES_WRITTEN, cryptogram.length() + 1);
+	return 0;
+  }
+        
+  /**
+   * モードに応じた処理を実行する
+   * @param [in] arguments 引数情報を格納しているオブジェクト
+   * @param [out] cryptogram Enigmaによる変換後の文字列(-oで書き出したときは空)
+   * @return 終了ステータス(-oの出力ファイルを開けない・書き込めない場合は-1)
+   * @detail 変換経過の表示・記録(-t/-k/-T)はTraceExecuteで,-f/-oはStreamExecuteで逐次処理する
+   */
+  int Execute(const Arguments &arguments, std::string &cryptogram){
+	unsigned int mode = arguments.getMode();
+	cryptogram = "";
+	if(mode & SHOW_DEFAULT_KEY_ARRAY_MODE){
+	  std::cout << "\tDefault Key Array\n";
+	  ShowKeyArray();
+	  std::cout << std::endl;
+	}
+	if(mode & (SHOW_TRANSITION_MODE | SHOW_KEY_ARRAY_MODE | TRACE_FILE_MODE)){
+	  return TraceExecute(arguments, cryptogram);
+	}
+	if((mode & READ_FILE_MODE) && (mode & OUT_FILE_MODE)){
+	  return StreamExecute(arguments);
+	}
+	std::string result = "";
+	{
+	  ENIGMA_STAGE(STAGE_ENCRYPT);
+	  result = ParallelEncryption(arguments.getCode(), arguments.getJobs(), mode);
+	}
+	if(mode & OUT_FILE_MODE){
+	  return WriteOutFile(arguments, result);
+	}
+	cryptogram = result;
+	return 0;
+  }
+};
+
+//3枚のリングのエニグマ(キーが3文字のとき)
+typedef BasicEnigma<3> Enigma;
+
+static_assert(std::is_trivially_copyable<Enigma>::value, "Enigma must be copyable with memcpy");
+
+#endif // ENIGMA_H
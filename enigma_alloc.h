@@ -0,0 +1,53 @@
+/**
+ * @brief ヒープ領域の確保回数を数えるための計測用フック
+ * @author Hirokazu Kiyomaru
+ * @attention グローバルなoperator new/deleteを置き換えるので,プログラム中の
+ *            1つの翻訳単位(mainを持つファイル)からだけインクルードすること
+ * @file enigma_alloc.h
+ */
+
+#ifndef ENIGMA_ALLOC_H
+#define ENIGMA_ALLOC_H
+
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+//プログラム開始からのoperator newの呼び出し回数
+static std::atomic<unsigned long long> allocationCount(0);
+
+/**
+ * @brief プログラム開始からのヒープ領域の確保回数を返す
+ * @param なし
+ * @return operator newの呼び出し回数(全スレッドの合計)
+ */
+inline unsigned long long GetAllocationCount(){
+  return allocationCount.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 確保回数を数えるoperator new
+ * @param [in] size 確保するバイト数
+ * @return 確保した領域
+ * @detail newとdeleteは,呼び出し側に展開されるとmallocとdeleteやnewとfreeの組み合わせとして
+ *         誤って警告される(-Wmismatched-new-delete)ので,どちらも展開させない
+ */
+__attribute__((noinline)) void *operator new(std::size_t size){
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  void *p = malloc(size ? size : 1);
+  if(p == NULL){
+	throw std::bad_alloc();
+  }
+  return p;
+}
+
+/**
+ * @brief operator newで確保した領域を解放する
+ * @param [in] p 解放する領域
+ * @return なし
+ */
+__attribute__((noinline)) void operator delete(void *p) noexcept{
+  free(p);
+}
+
+#endif // ENIGMA_ALLOC_H
@@ -0,0 +1,1358 @@
+/**
+ * @brief エニグマの暗号文だけからキーを探索する
+ * @author Hirokazu Kiyomaru
+ * @attention g++ -std=c++11 としてコンパイル
+ * @file enigma_attack.h
+ * @detail 全キー(26^3通り)で複号化した結果を統計量で採点し,上位のキーを返す.
+ *         キーはMultiKeyEncipherのレーン数ずつまとめて1つの仕事とし,複数のスレッドで
+ *         仕事を分け合う(手の空いたスレッドは他のスレッドの残りを半分奪う).
+ *         平文の一部(クリブ)がわかっている場合は,クリブを置ける位置を選別してから
+ *         その位置と全キーの組を同じ仕組みで調べる.
+ *         キーがわかっている場合は,プラグボードを山登り法で探す
+ */
+#ifndef ENIGMA_ATTACK_H
+#define ENIGMA_ATTACK_H
+
+//C++の標準ライブラリ
+#include <math.h>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <random>
+
+#include "enigma.h"
+#include "enigma_ngram.h"
+#include "enigma_checkpoint.h"
+
+/**
+ * @brief 複号化した結果の採点方法
+ */
+enum ScoreType{
+  SCORE_IOC = 0,     //一致指数(英文で約0.066,ランダムな文字列で約0.038)
+  SCORE_MONOGRAM = 1 //英文の文字の出現頻度に対する1文字あたりの対数尤度(log10)
+};
+
+//プラグボードの探索の採点に用いるn-gramの文字数
+static const int PLUGBOARD_NGRAM_ORDER = 4;
+
+//英文の文字の出現頻度(%)
+static const double ENGLISH_MONOGRAM[26] = {
+  8.167, 1.492, 2.782, 4.253, 12.702, 2.228, 2.015, 6.094, 6.966, 0.153, 0.772, 4.025, 2.406,
+  6.749, 7.507, 1.929, 0.095, 5.987, 6.327, 9.056, 2.758, 0.978, 2.360, 0.150, 1.974, 0.074
+};
+
+/**
+ * @struct Candidate
+ * @brief キーの候補と点数
+ */
+struct Candidate{
+  double score;          //点数(大きいほど平文らしい)
+  unsigned int keyIndex; //キーの番号(キーを合わせた直後のring1~3の位置p1,p2,p3に対して(p1 * 26 + p2) * 26 + p3)
+
+  /**
+   * @brief 点数の高い順(同点ならキーの番号の小さい順)に並べるための比較
+   * @param [in] other 比べる候補
+   * @return 自分が先に来るならtrue
+   */
+  bool operator<(const Candidate &other) const{
+	return (score != other.score) ? score > other.score : keyIndex < other.keyIndex;
+  }
+};
+
+/**
+ * @brief 候補を上位limit個の中に入れる
+ * @param [in,out] best 点数の高い順に並んだ候補
+ * @param [in] candidate 入れる候補
+ * @param [in] limit 残す候補の数
+ * @return なし
+ */
+inline void PushCandidate(std::vector<Candidate> &best, const Candidate &candidate, const size_t limit){
+  if(best.size() == limit && !(candidate < best.back())){
+	return;
+  }
+  best.insert(std::upper_bound(best.begin(), best.end(), candidate), candidate);
+  if(best.size() > limit){
+	best.pop_back();
+  }
+}
+
+/**
+ * @class Scorer
+ * @brief 文字の出現回数から平文らしさを採点する
+ */
+class Scorer{
+private:
+  ScoreType type;    //採点方法
+  double logp[26];   //英文の文字の出現確率の対数(log10)
+public:
+  /**
+   * コンストラクタ
+   * @param [in] type 採点方法
+   */
+  explicit Scorer(const ScoreType type) : type(type){
+	for(int i = 0; i < 26; i++){
+	  logp[i] = log10(ENGLISH_MONOGRAM[i] / 100.0);
+	}
+  }
+
+  /**
+   * @brief 採点する
+   * @param [in] counts 文字ごとの出現回数(26要素)
+   * @param [in] length 文字数
+   * @return 点数(大きいほど平文らしい)
+   */
+  double Score(const unsigned int *counts, const unsigned long long length) const{
+	if(length < 2){
+	  return 0.0;
+	}
+	double sum = 0.0;
+	if(type == SCORE_MONOGRAM){
+	  for(int i = 0; i < 26; i++){
+		sum += counts[i] * logp[i];
+	  }
+	  return sum / length;
+	}
+	for(int i = 0; i < 26; i++){
+	  sum += (double)counts[i] * (counts[i] - 1);
+	}
+	return sum / ((double)length * (length - 1));
+  }
+
+  /**
+   * @brief typeに対するgetアクセサ
+   * @param なし
+   * @return 採点方法
+   */
+  inline ScoreType getType() const{
+	return type;
+  }
+};
+
+/**
+ * @class WorkQueue
+ * @brief 仕事の番号の範囲を複数のスレッドで分け合う
+ * @detail 各スレッドに連続した仕事の範囲を割り当て,先頭から順に取らせる.自分の範囲を
+ *         終えたスレッドは,残りの最も多いスレッドの範囲の後ろ半分を奪って続ける
+ *         (ワークスティーリング)
+ */
+class WorkQueue{
+private:
+  /**
+   * @struct WorkRange
+   * @brief スレッドごとの残りの仕事の範囲[begin, end)
+   */
+  struct WorkRange{
+	std::mutex mtx;
+	unsigned long long begin = 0;
+	unsigned long long end = 0;
+  };
+
+  std::vector<WorkRange> ranges; //スレッドごとの残りの仕事の範囲
+  DISALLOW_COPY_AND_ASSIGN(WorkQueue);
+public:
+  /**
+   * コンストラクタ
+   * @param [in] first 最初の仕事の番号
+   * @param [in] last 最後の仕事の次の番号
+   * @param [in] workers スレッド数
+   */
+  WorkQueue(const unsigned long long first, const unsigned long long last, const size_t workers)
+	: ranges(std::max<size_t>(1, workers)){
+	unsigned long long units = last - first;
+	for(size_t i = 0; i < ranges.size(); i++){
+	  ranges[i].begin = first + units * i / ranges.size();
+	  ranges[i].end = first + units * (i + 1) / ranges.size();
+	}
+  }
+
+  /**
+   * @brief 次の仕事を取る
+   * @param [in] self 自分のスレッドの番号
+   * @param [out] unit 取った仕事
+   * @return 仕事が残っていなければfalse
+   */
+  bool Pop(const size_t self, unsigned long long &unit){
+	/*自分の範囲の先頭から取る*/
+	{
+	  std::lock_guard<std::mutex> lock(ranges[self].mtx);
+	  if(ranges[self].begin < ranges[self].end){
+		unit = ranges[self].begin++;
+		return true;
+	  }
+	}
+
+	/*残りの最も多いスレッドの範囲の後ろ半分を奪う*/
+	while(true){
+	  size_t victim = self;
+	  unsigned long long most = 0;
+	  for(size_t i = 0; i < ranges.size(); i++){
+		std::lock_guard<std::mutex> lock(ranges[i].mtx);
+		if(ranges[i].end - ranges[i].begin > most){
+		  most = ranges[i].end - ranges[i].begin;
+		  victim = i;
+		}
+	  }
+	  if(most == 0){
+		return false;
+	  }
+	  unsigned long long begin = 0, end = 0;
+	  {
+		std::lock_guard<std::mutex> lock(ranges[victim].mtx);
+		unsigned long long rest = ranges[victim].end - ranges[victim].begin;
+		if(rest == 0){
+		  continue; //数えている間に取られたのでやり直す
+		}
+		end = ranges[victim].end;
+		begin = end - (rest + 1) / 2;
+		ranges[victim].end = begin;
+	  }
+	  std::lock_guard<std::mutex> lock(ranges[self].mtx);
+	  ranges[self].begin = begin + 1;
+	  ranges[self].end = end;
+	  unit = begin;
+	  return true;
+	}
+  }
+
+  /**
+   * @brief スレッド数を返す
+   * @param なし
+   * @return スレッド数
+   */
+  inline size_t getWorkers() const{
+	return ranges.size();
+  }
+};
+
+/**
+ * @brief キーの番号からキーを合わせた直後のring1~3の位置を求める
+ * @param [in] key_index キーの番号
+ * @param [out] start ring1~3の位置
+ * @return なし
+ */
+template <typename T>
+inline void KeyIndex2Start(const unsigned int key_index, T *start){
+  start[0] = key_index / 676;
+  start[1] = key_index / 26 % 26;
+  start[2] = key_index % 26;
+}
+
+/**
+ * @brief キーの番号をキーの文字列に直す
+ * @param [in] config 配線
+ * @param [in] key_index キーの番号
+ * @return 大文字アルファベット3文字のキー(-sに渡せる形)
+ */
+inline std::string KeyIndex2Key(const EnigmaConfig &config, const unsigned int key_index){
+  int start[3];
+  KeyIndex2Start(key_index, start);
+  return config.CurrentKey(RingCursor(start));
+}
+
+/**
+ * @class KeySearch
+ * @brief 暗号文だけから全キーを探索する
+ * @detail キーの番号をLANES個ずつ区切ったものを仕事(unit)とし,WorkQueueで
+ *         複数のスレッドに分け合わせる.チェックポイントには終えた仕事の印と上位の候補を書き,
+ *         再開するときは印のない仕事だけを行う
+ */
+class KeySearch{
+private:
+  const EnigmaConfig *config;       //配線
+  std::vector<uint8_t> ciphertext;  //暗号文(アルファベットのID)
+  unsigned long long offset;        //暗号文の先頭がキーを合わせてから何文字目か
+  Scorer scorer;                    //採点方法
+  unsigned int candidates;          //返す候補の数
+  double threshold;                 //この点数以上の候補が見つかったら打ち切る(0以下なら打ち切らない)
+  unsigned int jobs;                //スレッド数
+  std::atomic<unsigned long long> searched; //採点したキーの数
+  std::atomic<bool> stopped;        //打ち切ったらtrue
+  std::mutex mtx;                   //best,done,searchedとチェックポイントの書き出しを守る
+  std::vector<Candidate> best;      //点数の高い順に並んだ候補(candidates個まで)
+  std::vector<uint8_t> done;        //終えた仕事なら1
+  CheckpointTimer checkpoint;       //チェックポイントの書き出し
+  DISALLOW_COPY_AND_ASSIGN(KeySearch);
+
+  /**
+   * @brief 探索の条件の指紋を求める
+   * @param なし
+   * @return 指紋
+   * @detail 同じ暗号文でも配線(プラグボード,リング,リフレクター)が違えば点数が変わるので,
+   *         配線も含める
+   */
+  uint64_t Fingerprint() const{
+	std::ostringstream oss;
+	oss << offset << ' ' << scorer.getType() << ' ' << candidates << ' ' << threshold << ' ';
+	oss.write((const char *)ciphertext.data(), ciphertext.size());
+	BatchTables tables;
+	config->ExportTables(RingCursor(), tables);
+	oss.write((const char *)tables.plugboard, sizeof(tables.plugboard));
+	oss.write((const char *)tables.rotor, sizeof(tables.rotor));
+	oss.write((const char *)tables.reflector, sizeof(tables.reflector));
+	return CheckpointFingerprint(oss.str());
+  }
+
+  /**
+   * @brief チェックポイントを書き出す(mtxを取った状態で呼ぶ)
+   * @param なし
+   * @return 終了ステータス
+   */
+  int WriteCheckpoint(){
+	return checkpoint.Write([this](){
+	  CheckpointWriter writer(CHECKPOINT_KEY_SEARCH, Fingerprint());
+	  writer.Put<uint64_t>(searched);
+	  writer.Put<uint8_t>(stopped);
+	  for(unsigned int unit = 0; unit < UNITS; unit += 8){
+		uint8_t bits = 0;
+		for(unsigned int i = 0; i < 8 && unit + i < UNITS; i++){
+		  bits |= done[unit + i] << i;
+		}
+		writer.Put(bits);
+	  }
+	  writer.Put<uint32_t>(best.size());
+	  for(size_t i = 0; i < best.size(); i++){
+		writer.Put(best[i].score);
+		writer.Put(best[i].keyIndex);
+	  }
+	  return writer;
+	});
+  }
+
+  /**
+   * @brief 候補を上位candidates個の中に入れる
+   * @param [in,out] best 点数の高い順に並んだ候補
+   * @param [in] candidate 入れる候補
+   * @return なし
+   */
+  void Push(std::vector<Candidate> &best, const Candidate &candidate) const{
+	PushCandidate(best, candidate, candidates);
+  }
+
+  /**
+   * @brief 1つの仕事(LANES個のキー)を採点する
+   * @param [in] unit 仕事の番号
+   * @param [out] out 複号化の作業領域(BLOCK_LENGTH x LANESバイト)
+   * @return なし
+   * @detail 採点し終えたら候補をbestに入れて仕事に印を付け,間隔が空いていればチェックポイントを書き出す
+   */
+  void SearchUnit(const unsigned int unit, std::vector<uint8_t> &out){
+	unsigned int first = unit * LANES;
+	unsigned int keys = std::min(LANES, RingSet::PERIOD - first);
+	uint8_t starts[LANES][3];
+	for(unsigned int k = 0; k < keys; k++){
+	  KeyIndex2Start(first + k, starts[k]);
+	}
+
+	/*暗号文をBLOCK_LENGTH文字ずつ全レーンで複号化し,レーンごとに文字を数える*/
+	unsigned int counts[LANES][26] = {{0}};
+	for(size_t pos = 0; pos < ciphertext.size(); pos += BLOCK_LENGTH){
+	  size_t length = std::min<size_t>(BLOCK_LENGTH, ciphertext.size() - pos);
+	  config->MultiKeyEncipher(starts, keys, &ciphertext[pos], length, offset + pos, &out[0]);
+	  for(size_t i = 0; i < length; i++){
+		const uint8_t *lane = &out[i * keys];
+		for(unsigned int k = 0; k < keys; k++){
+		  counts[k][lane[k]]++;
+		}
+	  }
+	}
+	std::lock_guard<std::mutex> lock(mtx);
+	for(unsigned int k = 0; k < keys; k++){
+	  Candidate candidate = {scorer.Score(counts[k], ciphertext.size()), first + k};
+	  Push(best, candidate);
+	  if(threshold > 0.0 && candidate.score >= threshold){
+		stopped = true;
+	  }
+	}
+	searched += keys;
+	done[unit] = 1;
+	if(checkpoint.Due()){
+	  WriteCheckpoint();
+	}
+  }
+public:
+  static const unsigned int LANES = 64;          //1つの仕事で同時に調べるキーの数
+  static const unsigned int UNITS = (RingSet::PERIOD + LANES - 1) / LANES; //仕事の数
+  static const size_t BLOCK_LENGTH = 4096;       //一度に複号化する文字数
+
+  /**
+   * コンストラクタ
+   * @param [in] config 配線
+   * @param [in] code 暗号文(大文字アルファベット)
+   * @param [in] offset 暗号文の先頭がキーを合わせてから何文字目か
+   * @param [in] type 採点方法
+   * @param [in] candidates 返す候補の数
+   * @param [in] threshold この点数以上の候補が見つかったら打ち切る(0以下なら打ち切らない)
+   * @param [in] jobs スレッド数
+   */
+  KeySearch(const EnigmaConfig &config, const std::string &code, const unsigned long long offset,
+			const ScoreType type, const unsigned int candidates, const double threshold,
+			const unsigned int jobs)
+	: config(&config), ciphertext(code.length()), offset(offset), scorer(type),
+	  candidates(std::max(1u, candidates)), threshold(threshold), jobs(std::max(1u, jobs)),
+	  searched(0), stopped(false), mtx(), best(), done(UNITS, 0), checkpoint(){
+	Alpha2AlphaID(code.data(), code.length(), ciphertext.data());
+  }
+
+  /**
+   * @brief チェックポイントを書き出すようにし,既にあればそこから再開する
+   * @param [in] file_name チェックポイントのファイル名
+   * @param [in] interval 書き出す間隔(秒)
+   * @return 再開したら1,新しく始めるなら0,チェックポイントが読めなければ-1
+   */
+  int Checkpoint(const std::string &file_name, const double interval){
+	checkpoint.Set(file_name, interval);
+	CheckpointReader reader;
+	int status = reader.Open(file_name, CHECKPOINT_KEY_SEARCH, Fingerprint());
+	if(status <= 0){
+	  return status;
+	}
+	uint64_t searched_keys = 0;
+	uint8_t stopped_flag = 0;
+	uint32_t count = 0;
+	bool ok = reader.Get(searched_keys) && reader.Get(stopped_flag);
+	for(unsigned int unit = 0; ok && unit < UNITS; unit += 8){
+	  uint8_t bits = 0;
+	  ok = reader.Get(bits);
+	  for(unsigned int i = 0; i < 8 && unit + i < UNITS; i++){
+		done[unit + i] = (bits >> i) & 1;
+	  }
+	}
+	ok = ok && reader.Get(count) && count <= candidates;
+	best.resize(ok ? count : 0);
+	for(size_t i = 0; ok && i < best.size(); i++){
+	  ok = reader.Get(best[i].score) && reader.Get(best[i].keyIndex) && best[i].keyIndex < RingSet::PERIOD;
+	}
+	if(!ok){
+	  std::cerr << "\tInvalid checkpoint. > " << file_name << std::endl;
+	  std::fill(done.begin(), done.end(), 0);
+	  best.clear();
+	  return -1;
+	}
+	searched = searched_keys;
+	stopped = stopped_flag;
+	return 1;
+  }
+
+  /**
+   * @brief 仕事の範囲[first_unit, last_unit)のキーを探索する
+   * @param [in] first_unit 最初の仕事の番号
+   * @param [in] last_unit 最後の仕事の次の番号
+   * @return 点数の高い順に並んだ候補(candidates個まで)
+   */
+  std::vector<Candidate> Run(const unsigned int first_unit = 0, const unsigned int last_unit = UNITS){
+	/*仕事の範囲をスレッドの数で等分して割り当てる*/
+	size_t workers = std::max(1u, std::min(jobs, last_unit - first_unit));
+	WorkQueue queue(first_unit, last_unit, workers);
+
+	/*チェックポイントから再開した場合は終えた仕事を飛ばす*/
+	checkpoint.Start();
+	std::vector<std::thread> threads;
+	for(size_t i = 0; i < workers; i++){
+	  threads.push_back(std::thread([this, i, &queue](){
+		std::vector<uint8_t> out(BLOCK_LENGTH * LANES);
+		unsigned long long unit = 0;
+		while(!stopped && queue.Pop(i, unit)){
+		  if(!done[unit]){
+			SearchUnit(unit, out);
+		  }
+		}
+	  }));
+	}
+	for(size_t i = 0; i < workers; i++){
+	  threads[i].join();
+	}
+	std::lock_guard<std::mutex> lock(mtx);
+	if(checkpoint.Enabled()){
+	  WriteCheckpoint();
+	}
+	return best;
+  }
+
+  /**
+   * @brief checkpointに対するgetアクセサ
+   * @param なし
+   * @return チェックポイントの書き出し(回数と時間)
+   */
+  inline const CheckpointTimer &getCheckpoint() const{
+	return checkpoint;
+  }
+
+  /**
+   * @brief searchedに対するgetアクセサ
+   * @param なし
+   * @return 採点したキーの数
+   */
+  inline unsigned long long getSearched() const{
+	return searched;
+  }
+
+  /**
+   * @brief stoppedに対するgetアクセサ
+   * @param なし
+   * @return しきい値に達して打ち切ったならtrue
+   */
+  inline bool getStopped() const{
+	return stopped;
+  }
+
+  /**
+   * @brief キーの番号をキーの文字列に直す
+   * @param [in] key_index キーの番号
+   * @return 大文字アルファベット3文字のキー(-sに渡せる形)
+   */
+  std::string KeyName(const unsigned int key_index) const{
+	return KeyIndex2Key(*config, key_index);
+  }
+};
+
+/**
+ * @struct CribMatch
+ * @brief クリブと一致したキーと位置
+ */
+struct CribMatch{
+  unsigned int keyIndex; //キーの番号
+  size_t position;       //暗号文の中でクリブが始まる位置
+
+  /**
+   * @brief 位置の小さい順(同じ位置ならキーの番号の小さい順)に並べるための比較
+   * @param [in] other 比べる一致
+   * @return 自分が先に来るならtrue
+   */
+  bool operator<(const CribMatch &other) const{
+	return (position != other.position) ? position < other.position : keyIndex < other.keyIndex;
+  }
+};
+
+/**
+ * @class CribSearch
+ * @brief 平文の一部(クリブ)から既知平文攻撃でキーを探索する
+ * @detail エニグマはどの文字も自分自身に暗号化しないので,まずクリブと暗号文で同じ文字が
+ *         重なる位置を除く(Screen).残った位置ごとに,クリブをその位置(キーを合わせてから
+ *         offset + 位置文字目)から全キーで暗号化し,暗号文と一致するキーを探す.
+ *         状態は位置から直接求まるので,位置ごとに先頭から機械を進め直すことはない.
+ *         (位置,キーLANES個)を1つの仕事とし,WorkQueueで複数のスレッドに分け合わせる
+ */
+class CribSearch{
+private:
+  std::vector<uint8_t> ciphertext;  //暗号文(アルファベットのID)
+  std::vector<uint8_t> crib;        //クリブ(アルファベットのID)
+  unsigned long long offset;        //暗号文の先頭がキーを合わせてから何文字目か
+  unsigned int jobs;                //スレッド数
+  BatchTables tables;               //一括暗号化カーネルに渡す換字表
+  std::vector<size_t> positions;    //選別で残った位置
+  std::atomic<unsigned long long> tested; //調べた(位置,キー)の組の数
+  DISALLOW_COPY_AND_ASSIGN(CribSearch);
+
+  /**
+   * @brief 1つの仕事(1つの位置とLANES個のキー)を調べる
+   * @param [in] unit 仕事の番号(位置の番号 * KeySearch::UNITS + キーの仕事の番号)
+   * @param [in,out] matches 一致したキーと位置
+   * @param [out] out 暗号化の作業領域(CHUNK_LENGTH x LANESバイト)
+   * @return なし
+   */
+  void SearchUnit(const unsigned long long unit, std::vector<CribMatch> &matches,
+				  std::vector<uint8_t> &out){
+	size_t position = positions[unit / KeySearch::UNITS];
+	unsigned int first = (unit % KeySearch::UNITS) * LANES;
+	unsigned int keys = std::min(LANES, RingSet::PERIOD - first);
+	uint8_t starts[LANES][3];
+	for(unsigned int k = 0; k < keys; k++){
+	  KeyIndex2Start(first + k, starts[k]);
+	}
+
+	/*クリブをCHUNK_LENGTH文字ずつ全レーンで暗号化し,一致の残ったレーンがなくなれば打ち切る*/
+	uint64_t alive = (keys == 64) ? ~0ULL : ((1ULL << keys) - 1);
+	for(size_t i = 0; i < crib.size() && alive != 0; i += CHUNK_LENGTH){
+	  size_t length = std::min(CHUNK_LENGTH, crib.size() - i);
+	  ::MultiKeyEncipher(tables, starts, keys, &crib[i], length, offset + position + i, &out[0]);
+	  for(size_t j = 0; j < length; j++){
+		const uint8_t *lane = &out[j * keys];
+		uint8_t expected = ciphertext[position + i + j];
+		for(unsigned int k = 0; k < keys; k++){
+		  if(lane[k] != expected){
+			alive &= ~(1ULL << k);
+		  }
+		}
+	  }
+	}
+	for(unsigned int k = 0; k < keys; k++){
+	  if(alive & (1ULL << k)){
+		CribMatch match = {first + k, position};
+		matches.push_back(match);
+	  }
+	}
+	tested += keys;
+  }
+public:
+  static const unsigned int LANES = KeySearch::LANES; //1つの仕事で同時に調べるキーの数
+  static const size_t CHUNK_LENGTH = 8;          //一致を確かめるまでに一度に暗号化する文字数
+  static const size_t SCREEN_GRAIN = 1 << 16;    //選別で1スレッドに割り当てる最小の位置の数
+
+  /**
+   * コンストラクタ
+   * @param [in] config 配線
+   * @param [in] code 暗号文(大文字アルファベット)
+   * @param [in] crib クリブ(大文字アルファベット)
+   * @param [in] offset 暗号文の先頭がキーを合わせてから何文字目か
+   * @param [in] jobs スレッド数
+   */
+  CribSearch(const EnigmaConfig &config, const std::string &code, const std::string &crib,
+			 const unsigned long long offset, const unsigned int jobs)
+	: ciphertext(code.length()), crib(crib.length()), offset(offset), jobs(std::max(1u, jobs)),
+	  tested(0){
+	Alpha2AlphaID(code.data(), code.length(), ciphertext.data());
+	Alpha2AlphaID(crib.data(), crib.length(), this->crib.data());
+	config.ExportTables(RingCursor(), tables);
+  }
+
+  /**
+   * @brief クリブを置ける位置を選別する
+   * @param なし
+   * @return クリブと暗号文で同じ文字が重ならない位置(小さい順)
+   * @detail 位置の範囲をスレッドの数で等分し,それぞれScreenCribで調べる
+   */
+  const std::vector<size_t> &Screen(){
+	positions.clear();
+	if(crib.empty() || crib.size() > ciphertext.size()){
+	  return positions;
+	}
+	size_t total = ciphertext.size() - crib.size() + 1;
+	size_t workers = std::max<size_t>(1, std::min<size_t>(jobs, total / SCREEN_GRAIN));
+	std::vector<uint8_t> ok(total);
+	std::vector<std::thread> threads;
+	for(size_t i = 0; i < workers; i++){
+	  threads.push_back(std::thread([this, i, workers, total, &ok](){
+		size_t begin = total * i / workers;
+		size_t end = total * (i + 1) / workers;
+		ScreenCrib(&ciphertext[begin], end - begin, crib.data(), crib.size(), &ok[begin]);
+	  }));
+	}
+	for(size_t i = 0; i < workers; i++){
+	  threads[i].join();
+	}
+	for(size_t j = 0; j < total; j++){
+	  if(ok[j]){
+		positions.push_back(j);
+	  }
+	}
+	return positions;
+  }
+
+  /**
+   * @brief 選別で残った全ての位置で全キーを調べる
+   * @param なし
+   * @return 一致したキーと位置(位置の小さい順)
+   */
+  std::vector<CribMatch> Run(){
+	Screen();
+	unsigned long long units = (unsigned long long)positions.size() * KeySearch::UNITS;
+	size_t workers = std::max<unsigned long long>(1, std::min<unsigned long long>(jobs, units));
+	WorkQueue queue(0, units, workers);
+
+	/*各スレッドが自分の一致を集め,最後にまとめる*/
+	std::vector<std::vector<CribMatch> > matches(workers);
+	std::vector<std::thread> threads;
+	for(size_t i = 0; i < workers; i++){
+	  threads.push_back(std::thread([this, i, &queue, &matches](){
+		std::vector<uint8_t> out(CHUNK_LENGTH * LANES);
+		unsigned long long unit = 0;
+		while(queue.Pop(i, unit)){
+		  SearchUnit(unit, matches[i], out);
+		}
+	  }));
+	}
+	for(size_t i = 0; i < workers; i++){
+	  threads[i].join();
+	}
+	std::vector<CribMatch> result;
+	for(size_t i = 0; i < workers; i++){
+	  result.insert(result.end(), matches[i].begin(), matches[i].end());
+	}
+	std::sort(result.begin(), result.end());
+	return result;
+  }
+
+  /**
+   * @brief testedに対するgetアクセサ
+   * @param なし
+   * @return 調べた(位置,キー)の組の数
+   */
+  inline unsigned long long getTested() const{
+	return tested;
+  }
+
+  /**
+   * @brief 選別する前の位置の数を返す
+   * @param なし
+   * @return クリブを置ける位置の数(暗号文の文字数 - クリブの文字数 + 1)
+   */
+  inline size_t getTotalPositions() const{
+	return (crib.empty() || crib.size() > ciphertext.size()) ? 0 : ciphertext.size() - crib.size() + 1;
+  }
+
+  /**
+   * @brief positionsに対するgetアクセサ
+   * @param なし
+   * @return 選別で残った位置(小さい順)
+   */
+  inline const std::vector<size_t> &getPositions() const{
+	return positions;
+  }
+};
+
+/**
+ * @class PlugboardSearch
+ * @brief キーがわかっている暗号文のプラグボードを山登り法で探す
+ * @detail プラグボードをP,キーを合わせてからn文字目のリングとリフレクターの変換をC_nとすると,
+ *         平文はP^-1(C_n(P(暗号文)))となる.C_nは探索の前に全ての位置で求めておく.
+ *         ランダムなプラグボードから始め,キー配列の2要素を入れ替える操作を焼きなましで
+ *         ANNEAL_SWEEPS周試した後,点数が上がらなくなるまで山登りし,またやり直す.
+ *         入れ替えで平文が変わるのは,暗号文が入れ替えた2文字である位置と,
+ *         リングとリフレクターを通った後の文字が入れ替えた2文字の行き先である位置だけなので,
+ *         その位置を含むn-gramだけを数え直して点数の差分を求める.
+ *         チェックポイントには,スレッドごとに1周(全ての入れ替えを1回ずつ試す)の区切りでの
+ *         乱数の状態と,途中のプラグボードとその周回数,最良のプラグボード,使った時間を書く.
+ *         再開するときは各スレッドがその周回の続きから焼きなまし・山登りを続けるので,
+ *         やり直しの途中で書いたチェックポイントからでも,書いた後の分しかやり直さない
+ */
+class PlugboardSearch{
+private:
+  /**
+   * @struct State
+   * @brief 1つのスレッドが山登りしているプラグボードと平文
+   */
+  struct State{
+	uint8_t going[26];                         //プラグボード(行き)
+	uint8_t returning[26];                     //プラグボード(帰り)
+	std::vector<uint8_t> middle;               //リングとリフレクターを通った後の文字
+	std::vector<uint8_t> plain;                //平文
+	std::vector<std::vector<uint32_t> > byMiddle; //middleが各文字である位置
+	std::vector<uint32_t> slot;                //各位置がbyMiddleの何番目にあるか
+	std::vector<uint32_t> positionMark;        //差分を求める位置に印をつける
+	std::vector<uint32_t> startMark;           //数え直すn-gramの先頭に印をつける
+	uint32_t stamp;                            //今の入れ替えの印
+	std::vector<uint32_t> changed;             //平文が変わりうる位置
+	std::vector<uint32_t> starts;              //数え直すn-gramの先頭
+	std::vector<uint8_t> saved;                //変える前の平文
+	double score;                              //今のプラグボードの点数
+  };
+
+  /**
+   * @struct Progress
+   * @brief 1つのスレッドの,最後に1周を終えた時点での進み具合
+   */
+  struct Progress{
+	std::mt19937 mt;             //次の周回に用いる乱数
+	int32_t sweep;               //今のやり直しで終えた周回数(-1なら次はランダムなプラグボードから始める)
+	uint8_t current[26];         //今のやり直しのプラグボード(行き,sweepが0以上のとき)
+	unsigned long long restarts; //やり直した回数
+	unsigned long long moves;    //試した入れ替えの回数
+	double bestScore;            //最も高い点数
+	uint8_t best[26];            //最も点数の高いプラグボード(行き)
+  };
+
+  const NgramModel *model;          //採点に用いるn-gram
+  std::vector<uint8_t> ciphertext;  //暗号文(アルファベットのID)
+  std::vector<uint8_t> core;        //位置nでリングとリフレクターを通した結果(core[n * 26 + code])
+  std::vector<std::vector<uint32_t> > byCipher; //暗号文が各文字である位置
+  unsigned int jobs;                //スレッド数
+  double budget;                    //探索に使う秒数
+  std::atomic<unsigned long long> restarts; //やり直した回数
+  std::atomic<unsigned long long> moves;    //試した入れ替えの回数
+  std::mutex mtx;                   //progressとチェックポイントの書き出しを守る
+  std::vector<Progress> progress;   //スレッドごとの進み具合(再開したらチェックポイントの内容)
+  double elapsed;                   //前回までに探索に使った秒数
+  CheckpointTimer checkpoint;       //チェックポイントの書き出し
+  DISALLOW_COPY_AND_ASSIGN(PlugboardSearch);
+
+  /**
+   * @brief 探索の条件の指紋を求める
+   * @param なし
+   * @return 指紋
+   * @detail キーと位置,配線はリングとリフレクターの変換(core)に表れるので,それを含める
+   */
+  uint64_t Fingerprint() const{
+	std::ostringstream oss;
+	oss << jobs << ' ' << budget << ' ' << model->getOrder() << ' ';
+	oss.write((const char *)ciphertext.data(), ciphertext.size());
+	oss.write((const char *)core.data(), core.size());
+	return CheckpointFingerprint(oss.str());
+  }
+
+  /**
+   * @brief チェックポイントを書き出す(mtxを取った状態で呼ぶ)
+   * @param [in] begin 今回の探索を始めた時刻
+   * @return 終了ステータス
+   */
+  int WriteCheckpoint(const std::chrono::steady_clock::time_point begin){
+	return checkpoint.Write([this, begin](){
+	  CheckpointWriter writer(CHECKPOINT_PLUGBOARD_SEARCH, Fingerprint());
+	  writer.Put<double>(elapsed + std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+	  for(size_t t = 0; t < progress.size(); t++){
+		std::ostringstream state;
+		state << progress[t].mt;
+		writer.PutString(state.str());
+		writer.Put<int32_t>(progress[t].sweep);
+		writer.Put(progress[t].current);
+		writer.Put<uint64_t>(progress[t].restarts);
+		writer.Put<uint64_t>(progress[t].moves);
+		writer.Put(progress[t].bestScore);
+		writer.Put(progress[t].best);
+	  }
+	  return writer;
+	});
+  }
+
+  /**
+   * @brief 位置nのmiddleをbyMiddleに登録する
+   * @param [in,out] s 状態
+   * @param [in] n 位置
+   * @return なし
+   */
+  static void Attach(State &s, const uint32_t n){
+	s.slot[n] = s.byMiddle[s.middle[n]].size();
+	s.byMiddle[s.middle[n]].push_back(n);
+  }
+
+  /**
+   * @brief 位置nのmiddleをbyMiddleから外す
+   * @param [in,out] s 状態
+   * @param [in] n 位置
+   * @return なし
+   */
+  static void Detach(State &s, const uint32_t n){
+	std::vector<uint32_t> &bucket = s.byMiddle[s.middle[n]];
+	bucket[s.slot[n]] = bucket.back();
+	s.slot[bucket.back()] = s.slot[n];
+	bucket.pop_back();
+  }
+
+  /**
+   * @brief プラグボードから平文と点数を全て求め直す
+   * @param [in,out] s 状態(goingとreturningを設定済みのもの)
+   * @return なし
+   */
+  void Rebuild(State &s) const{
+	for(int i = 0; i < 26; i++){
+	  s.byMiddle[i].clear();
+	}
+	for(uint32_t n = 0; n < ciphertext.size(); n++){
+	  s.middle[n] = core[n * 26 + s.going[ciphertext[n]]];
+	  s.plain[n] = s.returning[s.middle[n]];
+	  Attach(s, n);
+	}
+	s.score = model->Score(s.plain.data(), s.plain.size());
+  }
+
+  /**
+   * @brief キー配列のa番目とb番目を入れ替え,点数の差がmarginを上回れば採用する
+   * @param [in,out] s 状態
+   * @param [in] a アルファベットのID
+   * @param [in] b アルファベットのID
+   * @param [in] margin 採用する点数の差の下限(0なら点数が上がるときだけ採用する)
+   * @return 採用したらtrue
+   */
+  bool TryMove(State &s, const uint8_t a, const uint8_t b, const double margin = 0.0) const{
+	const int order = model->getOrder();
+	const uint32_t length = ciphertext.size();
+	const uint8_t va = s.going[a], vb = s.going[b];
+
+	/*平文が変わりうる位置と,それを含むn-gramの先頭を集める*/
+	s.stamp++;
+	s.changed.clear();
+	s.starts.clear();
+	const std::vector<uint32_t> *buckets[4] = {&byCipher[a], &byCipher[b], &s.byMiddle[va], &s.byMiddle[vb]};
+	for(int i = 0; i < 4; i++){
+	  for(size_t j = 0; j < buckets[i]->size(); j++){
+		uint32_t n = (*buckets[i])[j];
+		if(s.positionMark[n] == s.stamp){
+		  continue;
+		}
+		s.positionMark[n] = s.stamp;
+		s.changed.push_back(n);
+		uint32_t first = (n + 1 >= (uint32_t)order) ? n + 1 - order : 0;
+		uint32_t last = std::min(n, length - order);
+		for(uint32_t start = first; start <= last; start++){
+		  if(s.startMark[start] != s.stamp){
+			s.startMark[start] = s.stamp;
+			s.starts.push_back(start);
+		  }
+		}
+	  }
+	}
+
+	/*入れ替える前と後で,集めたn-gramの点数の差を求める*/
+	double before = 0.0, after = 0.0;
+	for(size_t i = 0; i < s.starts.size(); i++){
+	  before += model->LogProb(&s.plain[s.starts[i]]);
+	}
+	s.going[a] = vb;
+	s.going[b] = va;
+	s.returning[va] = b;
+	s.returning[vb] = a;
+	s.saved.resize(s.changed.size());
+	for(size_t i = 0; i < s.changed.size(); i++){
+	  uint32_t n = s.changed[i];
+	  s.saved[i] = s.plain[n];
+	  s.plain[n] = s.returning[core[n * 26 + s.going[ciphertext[n]]]];
+	}
+	for(size_t i = 0; i < s.starts.size(); i++){
+	  after += model->LogProb(&s.plain[s.starts[i]]);
+	}
+
+	/*採用しなければ元に戻す*/
+	if(after - before <= margin){
+	  s.going[a] = va;
+	  s.going[b] = vb;
+	  s.returning[va] = a;
+	  s.returning[vb] = b;
+	  for(size_t i = 0; i < s.changed.size(); i++){
+		s.plain[s.changed[i]] = s.saved[i];
+	  }
+	  return false;
+	}
+
+	/*暗号文が入れ替えた2文字である位置はmiddleも変わる*/
+	for(int i = 0; i < 2; i++){
+	  for(size_t j = 0; j < buckets[i]->size(); j++){
+		uint32_t n = (*buckets[i])[j];
+		Detach(s, n);
+		s.middle[n] = core[n * 26 + s.going[ciphertext[n]]];
+		Attach(s, n);
+	  }
+	}
+	s.score += after - before;
+	return true;
+  }
+public:
+  static const int ANNEAL_SWEEPS = 50;          //1回の山登りの初めに焼きなましを行う周回数
+  static constexpr double ANNEAL_TEMPERATURE = 10.0; //焼きなましの初めの温度(点数の差の尺度)
+
+  /**
+   * コンストラクタ
+   * @param [in] config 配線(プラグボード以外を用いる)
+   * @param [in] model 採点に用いるn-gram
+   * @param [in] key キー(大文字アルファベット3文字)
+   * @param [in] code 暗号文(大文字アルファベット)
+   * @param [in] offset 暗号文の先頭がキーを合わせてから何文字目か
+   * @param [in] jobs スレッド数
+   * @param [in] budget 探索に使う秒数
+   */
+  PlugboardSearch(const EnigmaConfig &config, const NgramModel &model, const std::string &key,
+				  const std::string &code, const unsigned long long offset,
+				  const unsigned int jobs, const double budget)
+	: model(&model), ciphertext(code.length()), core(code.length() * 26), byCipher(26),
+	  jobs(std::max(1u, jobs)), budget(budget), restarts(0), moves(0), mtx(),
+	  progress(std::max(1u, jobs)), elapsed(0.0), checkpoint(){
+	Alpha2AlphaID(code.data(), code.length(), ciphertext.data());
+
+	/*スレッドごとに別の種で乱数を初期化する*/
+	std::random_device device;
+	unsigned int seed = device();
+	for(size_t t = 0; t < progress.size(); t++){
+	  progress[t].mt.seed(seed + t);
+	  progress[t].sweep = -1;
+	  progress[t].restarts = 0;
+	  progress[t].moves = 0;
+	  progress[t].bestScore = -HUGE_VAL;
+	  for(int i = 0; i < 26; i++){
+		progress[t].current[i] = i;
+		progress[t].best[i] = i;
+	  }
+	}
+
+	/*プラグボードを素通しにした配線で,各位置のリングとリフレクターの変換を求める*/
+	EnigmaConfig bare = EnigmaConfig(Plugboard());
+	RingCursor cursor = config.KeySet(key);
+	cursor.Seek(offset);
+	for(size_t n = 0; n < ciphertext.size(); n++){
+	  for(int code = 0; code < 26; code++){
+		core[n * 26 + code] = bare.Encipher(cursor, code);
+	  }
+	  cursor.EndCycle();
+	  byCipher[ciphertext[n]].push_back(n);
+	}
+  }
+
+  /**
+   * @brief チェックポイントを書き出すようにし,既にあればそこから再開する
+   * @param [in] file_name チェックポイントのファイル名
+   * @param [in] interval 書き出す間隔(秒)
+   * @return 再開したら1,新しく始めるなら0,チェックポイントが読めなければ-1
+   */
+  int Checkpoint(const std::string &file_name, const double interval){
+	checkpoint.Set(file_name, interval);
+	CheckpointReader reader;
+	int status = reader.Open(file_name, CHECKPOINT_PLUGBOARD_SEARCH, Fingerprint());
+	if(status <= 0){
+	  return status;
+	}
+	std::vector<Progress> loaded(progress);
+	double used = 0.0;
+	bool ok = reader.Get(used);
+	for(size_t t = 0; ok && t < loaded.size(); t++){
+	  std::string state;
+	  uint64_t restarts_count = 0, moves_count = 0;
+	  ok = reader.GetString(state) && reader.Get(loaded[t].sweep) && reader.Get(loaded[t].current)
+		&& reader.Get(restarts_count) && reader.Get(moves_count)
+		&& reader.Get(loaded[t].bestScore) && reader.Get(loaded[t].best);
+	  std::istringstream iss(state);
+	  iss >> loaded[t].mt;
+	  ok = ok && !iss.fail() && loaded[t].sweep >= -1;
+	  /*途中のプラグボードはキー配列の並べ替えになっていること*/
+	  uint32_t seen = 0;
+	  for(int i = 0; ok && i < 26; i++){
+		ok = loaded[t].current[i] < 26 && !(seen & (1u << loaded[t].current[i]));
+		seen |= 1u << loaded[t].current[i];
+	  }
+	  loaded[t].restarts = restarts_count;
+	  loaded[t].moves = moves_count;
+	}
+	if(!ok){
+	  std::cerr << "\tInvalid checkpoint. > " << file_name << std::endl;
+	  return -1;
+	}
+	progress = loaded;
+	elapsed = used;
+	unsigned long long restarts_total = 0, moves_total = 0;
+	for(size_t t = 0; t < progress.size(); t++){
+	  restarts_total += progress[t].restarts;
+	  moves_total += progress[t].moves;
+	}
+	restarts = restarts_total;
+	moves = moves_total;
+	return 1;
+  }
+
+  /**
+   * @brief 時間いっぱいまで各スレッドで山登りを繰り返し,最も点数の高いプラグボードを返す
+   * @param [out] score 返したプラグボードの点数(n-gramの出現確率の対数の和)
+   * @return 最も点数の高いプラグボード
+   * @detail チェックポイントから再開した場合は,前回までに使った時間を除いた残りだけ探索する
+   */
+  Plugboard Run(double &score){
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point deadline = begin
+	  + std::chrono::microseconds((long long)(std::max(0.0, budget - elapsed) * 1e6));
+	checkpoint.Start();
+
+	std::vector<std::thread> threads;
+	for(size_t t = 0; t < jobs; t++){
+	  threads.push_back(std::thread([this, t, begin, deadline](){
+		static const unsigned long long SWEEP_MOVES = 26 * 25 / 2; //1周で試す入れ替えの回数
+		std::mt19937 mt = progress[t].mt;
+		int32_t sweep = progress[t].sweep;
+		std::uniform_real_distribution<double> uniform(1e-300, 1.0);
+		State s;
+		s.middle.resize(ciphertext.size());
+		s.plain.resize(ciphertext.size());
+		s.byMiddle.resize(26);
+		s.slot.resize(ciphertext.size());
+		s.positionMark.assign(ciphertext.size(), 0);
+		s.startMark.assign(ciphertext.size(), 0);
+		s.stamp = 0;
+
+		/*やり直しの途中から再開する場合は,そのプラグボードから平文と点数を求め直す*/
+		if(sweep >= 0){
+		  std::copy(progress[t].current, progress[t].current + 26, s.going);
+		  for(int i = 0; i < 26; i++){
+			s.returning[s.going[i]] = i;
+		  }
+		  Rebuild(s);
+		}
+		while(std::chrono::steady_clock::now() < deadline){
+		  /*ランダムなプラグボードから始める*/
+		  if(sweep < 0){
+			for(int i = 0; i < 26; i++){
+			  s.going[i] = i;
+			}
+			std::shuffle(s.going, s.going + 26, mt);
+			for(int i = 0; i < 26; i++){
+			  s.returning[s.going[i]] = i;
+			}
+			Rebuild(s);
+			sweep = 0;
+		  }
+
+		  /*初めのANNEAL_SWEEPS周は温度を下げながら,点数の下がる入れ替えも確率exp(差/温度)で
+			採用する(焼きなまし).その後は,どの入れ替えでも点数が上がらなくなるまで登る*/
+		  bool improved = true;
+		  if(sweep < ANNEAL_SWEEPS){
+			double temperature = ANNEAL_TEMPERATURE * (ANNEAL_SWEEPS - sweep) / ANNEAL_SWEEPS;
+			for(uint8_t a = 0; a < 26; a++){
+			  for(uint8_t b = a + 1; b < 26; b++){
+				TryMove(s, a, b, temperature * log(uniform(mt)));
+			  }
+			}
+		  }else{
+			improved = false;
+			for(uint8_t a = 0; a < 26; a++){
+			  for(uint8_t b = a + 1; b < 26; b++){
+				improved |= TryMove(s, a, b);
+			  }
+			}
+		  }
+		  sweep++;
+		  moves += SWEEP_MOVES;
+
+		  /*差分の積み重ねによる誤差を除くため,やり直しを終えたら点数を求め直してから比べる*/
+		  bool finished = !improved;
+		  if(finished){
+			restarts++;
+			s.score = model->Score(s.plain.data(), s.plain.size());
+		  }
+
+		  /*1周ごとに進み具合を残すので,チェックポイントはやり直しの途中でも書ける*/
+		  std::lock_guard<std::mutex> lock(mtx);
+		  Progress &p = progress[t];
+		  p.mt = mt;
+		  p.moves += SWEEP_MOVES;
+		  if(finished){
+			p.restarts++;
+			if(s.score > p.bestScore){
+			  p.bestScore = s.score;
+			  std::copy(s.going, s.going + 26, p.best);
+			}
+			sweep = -1;
+		  }
+		  p.sweep = sweep;
+		  std::copy(s.going, s.going + 26, p.current);
+		  if(checkpoint.Due()){
+			WriteCheckpoint(begin);
+		  }
+		}
+
+		/*時間切れで途中になったやり直しも,そこまでのプラグボードを比べる(続きは再開したときに登る)*/
+		if(sweep >= 0){
+		  s.score = model->Score(s.plain.data(), s.plain.size());
+		  std::lock_guard<std::mutex> lock(mtx);
+		  Progress &p = progress[t];
+		  if(s.score > p.bestScore){
+			p.bestScore = s.score;
+			std::copy(s.going, s.going + 26, p.best);
+		  }
+		}
+	  }));
+	}
+	for(size_t t = 0; t < jobs; t++){
+	  threads[t].join();
+	}
+	if(checkpoint.Enabled()){
+	  WriteCheckpoint(begin);
+	}
+
+	size_t winner = 0;
+	for(size_t t = 1; t < progress.size(); t++){
+	  if(progress[t].bestScore > progress[winner].bestScore){
+		winner = t;
+	  }
+	}
+	int wiring[26];
+	std::copy(progress[winner].best, progress[winner].best + 26, wiring);
+	score = progress[winner].bestScore;
+	return Plugboard(wiring);
+  }
+
+  /**
+   * @brief restartsに対するgetアクセサ
+   * @param なし
+   * @return 山登りをやり直した回数(チェックポイントから再開したら前回までの分も含む)
+   */
+  inline unsigned long long getRestarts() const{
+	return restarts;
+  }
+
+  /**
+   * @brief elapsedに対するgetアクセサ
+   * @param なし
+   * @return 前回までに探索に使った秒数(再開していなければ0)
+   */
+  inline double getElapsed() const{
+	return elapsed;
+  }
+
+  /**
+   * @brief checkpointに対するgetアクセサ
+   * @param なし
+   * @return チェックポイントの書き出し(回数と時間)
+   */
+  inline const CheckpointTimer &getCheckpoint() const{
+	return checkpoint;
+  }
+
+  /**
+   * @brief movesに対するgetアクセサ
+   * @param なし
+   * @return 試した入れ替えの回数(チェックポイントから再開したら前回までの分も含む)
+   */
+  inline unsigned long long getMoves() const{
+	return moves;
+  }
+};
+
+/**
+ * @brief チェックポイントを設定し,既にあれば再開することを表示する
+ * @param [in,out] search 探索(KeySearchかPlugboardSearch)
+ * @param [in] arguments 引数情報を格納しているオブジェクト(-C,-i を見る)
+ * @return 終了ステータス
+ */
+template <typename Search>
+int SetupCheckpoint(Search &search, const Arguments &arguments){
+  if(arguments.getCheckpoint().empty()){
+	return 0;
+  }
+  int status = search.Checkpoint(arguments.getCheckpoint(), arguments.getInterval());
+  if(status > 0){
+	std::cout << "\t  -Resumed -> " << arguments.getCheckpoint() << "\n";
+  }
+  return (status < 0) ? -1 : 0;
+}
+
+/**
+ * @brief チェックポイントの書き出しにかかった時間を表示する
+ * @param [in] checkpoint チェックポイントの書き出し
+ * @param [in] sec 探索にかかった秒数
+ * @return なし
+ */
+inline void ShowCheckpoint(const CheckpointTimer &checkpoint, const double sec){
+  if(!checkpoint.Enabled()){
+	return;
+  }
+  std::cout << "\t  -Checkpoints -> " << checkpoint.getCount() << " written, "
+			<< checkpoint.getSeconds() * 1e3 << " msec (" << 100.0 * checkpoint.getSeconds() / sec
+			<< "% of the elapsed time)\n";
+}
+
+/**
+ * @brief キーの候補を順位と複号化した先頭40文字とともに表示する
+ * @param [in] config 配線
+ * @param [in] code 暗号文
+ * @param [in] offset 暗号文の先頭がキーを合わせてから何文字目か
+ * @param [in] best 点数の高い順に並んだ候補
+ * @return なし
+ */
+inline void ShowCandidates(const EnigmaConfig &config, const std::string &code,
+						   const unsigned long long offset, const std::vector<Candidate> &best){
+  for(size_t i = 0; i < best.size(); i++){
+	std::string key = KeyIndex2Key(config, best[i].keyIndex);
+	RingCursor cursor = config.KeySet(key);
+	cursor.Seek(offset);
+	std::string plain = config.Encryption(cursor, code.substr(0, 40));
+	std::cout << "\t  -Rank " << (i + 1) << " -> " << key << "  score " << best[i].score
+			  << "  " << plain << "\n";
+  }
+}
+
+/**
+ * @brief 暗号文だけからキーを探索し,上位の候補を表示する(-a)
+ * @param [in] config 配線
+ * @param [in] arguments 引数情報を格納しているオブジェクト(暗号文,-n,-c,-e,-g,-j,-C,-i を見る)
+ * @return 終了ステータス
+ */
+inline int AttackExecute(const EnigmaConfig &config, const Arguments &arguments){
+  std::string code = arguments.getCode();
+  KeySearch search(config, code, arguments.getOffset(), (ScoreType)arguments.getScore(),
+				   arguments.getCandidates(), arguments.getThreshold(), arguments.getJobs());
+  std::cout << "\tAttack Result\n";
+  if(SetupCheckpoint(search, arguments) < 0){
+	return -1;
+  }
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  std::vector<Candidate> best = search.Run();
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  double sec = std::chrono::duration<double>(end - begin).count();
+
+  /*結果出力*/
+  ShowCandidates(config, code, arguments.getOffset(), best);
+  std::cout << "\t  -Searched Keys -> " << search.getSearched() << " / " << RingSet::PERIOD
+			<< (search.getStopped() ? " (stopped at the threshold)" : "") << "\n";
+  ShowCheckpoint(search.getCheckpoint(), sec);
+  std::cout << "\t  -Elapsed Time -> " << sec << " sec" << std::endl;
+  return 0;
+}
+
+/**
+ * @brief 平文の一部(クリブ)からキーを探索し,一致したキーと位置を表示する(-w)
+ * @param [in] config 配線
+ * @param [in] arguments 引数情報を格納しているオブジェクト(暗号文,-w,-n,-j を見る)
+ * @return 終了ステータス
+ */
+inline int CribExecute(const EnigmaConfig &config, const Arguments &arguments){
+  std::string code = arguments.getCode();
+  CribSearch search(config, code, arguments.getCrib(), arguments.getOffset(), arguments.getJobs());
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  std::vector<CribMatch> matches = search.Run();
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  double sec = std::chrono::duration<double>(end - begin).count();
+
+  /*結果出力*/
+  std::cout << "\tCrib Attack Result\n";
+  for(size_t i = 0; i < matches.size(); i++){
+	std::string key = KeyIndex2Key(config, matches[i].keyIndex);
+	RingCursor cursor = config.KeySet(key);
+	cursor.Seek(arguments.getOffset());
+	std::string plain = config.Encryption(cursor, code.substr(0, 40));
+	std::cout << "\t  -Match -> " << key << "  position " << matches[i].position
+			  << "  " << plain << "\n";
+  }
+  std::cout << "\t  -Positions -> " << search.getPositions().size() << " / " << search.getTotalPositions()
+			<< " (after the no-self-encryption screen)\n";
+  std::cout << "\t  -Tested Candidates -> " << search.getTested() << "\n";
+  std::cout << "\t  -Elapsed Time -> " << sec << " sec";
+  if(search.getTested() > 0){
+	std::cout <<  " (" << sec * 1e3 * 1e6 / search.getTested() << " msec per 1M candidates)";
+  }
+  std::cout << std::endl;
+  return 0;
+}
+
+/**
+ * @brief キーを固定して暗号文のプラグボードを探し,結果を表示する(-q)
+ * @param [in] config 配線
+ * @param [in] arguments 引数情報を格納しているオブジェクト(暗号文,-s,-n,-l,-x,-j,-C,-i を見る)
+ * @return 終了ステータス
+ */
+inline int PlugboardExecute(const EnigmaConfig &config, const Arguments &arguments){
+  NgramModel model;
+  if(model.Open(arguments.getCorpus(), PLUGBOARD_NGRAM_ORDER) < 0){
+	return -1;
+  }
+  std::string code = arguments.getCode();
+  if(code.length() < (size_t)PLUGBOARD_NGRAM_ORDER){
+	std::cerr << "\tThe ciphertext is too short." << std::endl;
+	return -1;
+  }
+  PlugboardSearch search(config, model, arguments.getKey(), code, arguments.getOffset(),
+						 arguments.getJobs(), arguments.getBudget());
+  std::cout << "\tPlugboard Search Result\n";
+  if(SetupCheckpoint(search, arguments) < 0){
+	return -1;
+  }
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  double score = 0.0;
+  Plugboard plugboard = search.Run(score);
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  double sec = std::chrono::duration<double>(end - begin).count();
+
+  /*結果出力*/
+  EnigmaConfig found(plugboard);
+  RingCursor cursor = found.KeySet(arguments.getKey());
+  cursor.Seek(arguments.getOffset());
+  std::string plain = found.Encryption(cursor, code.substr(0, 60));
+  std::cout << "\t  -Plugboard -> " << plugboard.ToString() << "\n";
+  std::cout << "\t  -Score -> " << score / (code.length() - PLUGBOARD_NGRAM_ORDER + 1)
+			<< " per " << PLUGBOARD_NGRAM_ORDER << "-gram\n";
+  std::cout << "\t  -Decrypted String -> " << plain << "\n";
+  std::cout << "\t  -Restarts -> " << search.getRestarts() << "  (" << search.getMoves() / (search.getElapsed() + sec)
+			<< " moves/sec)\n";
+  ShowCheckpoint(search.getCheckpoint(), sec);
+  std::cout << "\t  -Elapsed Time -> " << sec << " sec" << std::endl;
+  return 0;
+}
+
+#endif // ENIGMA_ATTACK_H
@@ -0,0 +1,565 @@
+/**
+ * @brief エニグマの暗号化エンジンのベンチマーク
+ * @author Hirokazu Kiyomaru
+ * @attention g++ -std=c++11 -O2 としてコンパイル
+ * @file enigma_bench.cpp
+ */
+
+//C++の標準ライブラリ
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "enigma.h"
+#include "enigma_ngram.h"
+#include "enigma_alloc.h"
+
+/**
+ * @brief ランダムな大文字アルファベットの列を作る
+ * @param [in] length 文字数
+ * @return 作った文字列
+ */
+std::string MakeText(const size_t length){
+  std::string text(length, 'A');
+  std::mt19937 mt(1);
+  for(size_t i = 0; i < length; i++){
+	text[i] = 'A' + mt() % 26;
+  }
+  return text;
+}
+
+/**
+ * @brief 暗号化の処理速度を測って表示する
+ * @param [in] name 計測対象の名前
+ * @param [in] text 暗号化する文字列
+ * @param [in] expected 期待する暗号文(空なら照合しない)
+ * @param [in] encrypt 暗号化を行う関数(キーを合わせたエニグマと文字列を受け取る)
+ * @return 暗号文
+ */
+template <typename Function>
+std::string Measure(const std::string &name, const std::string &text,
+					const std::string &expected, Function encrypt){
+  Enigma enigma;
+  enigma.KeySet("ABC");
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  std::string cryptogram = encrypt(enigma, text);
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  double sec = std::chrono::duration<double>(end - begin).count();
+  std::cout << "\t" << name << "\t" << (text.length() / sec) << " chars/sec";
+  if(!expected.empty() && cryptogram != expected){
+	std::cout << "\t(MISMATCH)";
+  }
+  std::cout << std::endl;
+  return cryptogram;
+}
+
+/**
+ * @brief 短いメッセージを大量に暗号化したときの速度とヒープ領域の確保回数を表示する
+ * @param [in] count メッセージの数
+ * @param [in] length 1メッセージの文字数
+ * @return なし
+ * @detail 配線は共有し,メッセージごとにキーを合わせたカーソルを作る.
+ *         文字列を返すAPIとバッファに書き込むAPIを比べる
+ */
+void MeasureShortMessages(const size_t count, const size_t length){
+  const EnigmaConfig config;
+  std::string message = MakeText(length);
+  std::vector<char> buf(length);
+            
+  /*文字列を返すAPI*/
+  unsigned long long allocations = GetAllocationCount();
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  for(size_t i = 0; i < count; i++){
+	RingCursor cursor = config.KeySet("ABC");
+	std::string cryptogram = config.Encryption(cursor, message);
+	buf[0] = cryptogram[0];
+  }
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  double sec = std::chrono::duration<double>(end - begin).count();
+  std::cout << "\tShort(" << length << "B, string)\t" << (count / sec) << " msgs/sec\t"
+			<< double(GetAllocationCount() - allocations) / count << " allocations/msg" << std::endl;
+            
+  /*バッファに書き込むAPI*/
+  allocations = GetAllocationCount();
+  begin = std::chrono::steady_clock::now();
+  for(size_t i = 0; i < count; i++){
+	RingCursor cursor = config.KeySet("ABC");
+	config.Encryption(cursor, message.data(), length, &buf[0]);
+  }
+  end = std::chrono::steady_clock::now();
+  sec = std::chrono::duration<double>(end - begin).count();
+  std::cout << "\tShort(" << length << "B, buffer)\t" << (count / sec) << " msgs/sec\t"
+			<< double(GetAllocationCount() - allocations) / count << " allocations/msg" << std::endl;
+}
+
+/**
+ * @brief 1つの文字列を全キー(26^3通り)で暗号化する速度を表示する
+ * @param [in] length 文字数
+ * @return なし
+ * @detail KeySetとEncryptionをキーの数だけ繰り返す場合と,複数のキーを
+ *         SIMDのレーンに並べて同時に進める場合(MultiKeyEncipher)を比べる
+ */
+void MeasureAllKeys(const size_t length){
+  const EnigmaConfig config;
+  const size_t keys = RingSet::PERIOD;
+  std::string text = MakeText(length);
+  std::vector<uint8_t> ids(length);
+  Alpha2AlphaID(text.data(), length, ids.data());
+            
+  /*KeySetとEncryptionの繰り返し*/
+  std::vector<char> plain(length * keys);
+  std::vector<uint8_t> starts(keys * 3);
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  for(size_t k = 0; k < keys; k++){
+	std::string key = {char('A' + k / 676), char('A' + k / 26 % 26), char('A' + k % 26)};
+	RingCursor cursor = config.KeySet(key);
+	config.Encryption(cursor, text.data(), length, &plain[k * length]);
+	for(int r = 0; r < 3; r++){
+	  starts[k * 3 + r] = cursor.getStartPos(r);
+	}
+  }
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  double sec = std::chrono::duration<double>(end - begin).count();
+  std::cout << "\tAllKeys(" << length << "B, KeySet loop)\t" << (keys * length / sec) << " key-chars/sec" << std::endl;
+            
+  /*照合用に出力と同じ並び(文字ごとに全キー)に直す*/
+  std::vector<uint8_t> expected(length * keys);
+  for(size_t k = 0; k < keys; k++){
+	for(size_t i = 0; i < length; i++){
+	  expected[i * keys + k] = Alpha2AlphaID(plain[k * length + i]);
+	}
+  }
+            
+  /*複数のキーを同時に進める*/
+  const char *names[3] = {"scalar", "sse4.1", "avx2"};
+  std::vector<uint8_t> out(length * keys);
+  for(int kernel = BATCH_KERNEL_SCALAR; kernel <= BATCH_KERNEL_AVX2; kernel++){
+	begin = std::chrono::steady_clock::now();
+	config.MultiKeyEncipher((const uint8_t (*)[3])starts.data(), keys, ids.data(), length, 0,
+							out.data(), (BatchKernel)kernel);
+	end = std::chrono::steady_clock::now();
+	sec = std::chrono::duration<double>(end - begin).count();
+	std::cout << "\tAllKeys(" << length << "B, multi-key " << names[kernel] << ")\t"
+			  << (keys * length / sec) << " key-chars/sec";
+	if(out != expected){
+	  std::cout << "\t(MISMATCH)";
+	}
+	std::cout << std::endl;
+  }
+}
+
+/**
+ * @brief n-gramによる採点の速度と,n-gramの配列を用意する時間を表示する
+ * @param [in] length 採点する文字数
+ * @return なし
+ * @detail 英文の代わりにランダムな文字列からバイナリファイルを作ってmmapで読み,
+ *         Encryptionの出力をそのまま採点する.n-gramごとに番号を計算し直す場合と比べる
+ */
+void MeasureNgramScoring(const size_t length){
+  char corpus_name[] = "/tmp/enigma_bench_corpusXXXXXX";
+  char file_name[] = "/tmp/enigma_bench_ngramXXXXXX";
+  int corpus_fd = mkstemp(corpus_name);
+  int file_fd = mkstemp(file_name);
+  if(corpus_fd < 0 || file_fd < 0){
+	std::cout << "\tNgram -> skipped (cannot make temporary files)" << std::endl;
+	return;
+  }
+  close(corpus_fd);
+  close(file_fd);
+  std::ofstream(corpus_name) << MakeText(1 << 20);
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  NgramModel::Build(corpus_name, file_name);
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  std::cout << "\tNgram(build 2-4)\t" << std::chrono::duration<double, std::milli>(end - begin).count()
+			<< " msec" << std::endl;
+
+  Enigma enigma;
+  enigma.KeySet("ABC");
+  std::string cryptogram = enigma.Encryption(MakeText(length));
+  std::vector<uint8_t> ids(length);
+  Alpha2AlphaID(cryptogram.data(), length, ids.data());
+  for(int order = NGRAM_MIN_ORDER; order <= NGRAM_MAX_ORDER; order++){
+	NgramModel model;
+	begin = std::chrono::steady_clock::now();
+	model.Load(file_name, order);
+	end = std::chrono::steady_clock::now();
+	double load = std::chrono::duration<double, std::micro>(end - begin).count();
+
+	/*1文字ずつ番号をずらして採点する*/
+	begin = std::chrono::steady_clock::now();
+	double rolling = model.Score(cryptogram);
+	end = std::chrono::steady_clock::now();
+	double sec = std::chrono::duration<double>(end - begin).count();
+	std::cout << "\tNgram(" << order << ", rolling)\t" << (length / sec) << " chars/sec\t(load "
+			  << load << " usec)";
+
+	/*n-gramごとに番号を計算し直して採点する*/
+	begin = std::chrono::steady_clock::now();
+	double naive = 0.0;
+	for(size_t i = 0; i + order <= length; i++){
+	  naive += model.LogProb(&ids[i]);
+	}
+	end = std::chrono::steady_clock::now();
+	sec = std::chrono::duration<double>(end - begin).count();
+	std::cout << "\n\tNgram(" << order << ", per n-gram)\t" << (length / sec) << " chars/sec";
+	if(fabs(naive - rolling) > 1e-6 * fabs(naive)){
+	  std::cout << "\t(MISMATCH)";
+	}
+	std::cout << std::endl;
+  }
+  unlink(corpus_name);
+  unlink(file_name);
+}
+
+/**
+ * @brief フィルタモード(-r)のプロセス起動から終了までの時間を測って表示する
+ * @param [in] path enigmaの実行ファイルのパス
+ * @param [in] runs 起動する回数
+ * @return なし
+ */
+void MeasureStartup(const char *path, const int runs){
+  if(access(path, X_OK) != 0){
+	std::cout << "\tStartup Latency -> skipped (" << path << " not found)" << std::endl;
+	return;
+  }
+  const char message[] = "HELLOWORLD\n";
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  for(int i = 0; i < runs; i++){
+	int fds[2];
+	if(pipe(fds) < 0){
+	  return;
+	}
+	pid_t pid = fork();
+	if(pid == 0){
+	  int null_fd = open("/dev/null", O_WRONLY);
+	  dup2(fds[0], STDIN_FILENO);
+	  dup2(null_fd, STDOUT_FILENO);
+	  close(fds[0]);
+	  close(fds[1]);
+	  execl(path, path, "-r", "-s", "ABC", (char *)NULL);
+	  _exit(127);
+	}
+	close(fds[0]);
+	if(write(fds[1], message, sizeof(message) - 1) < 0){
+	  perror("write");
+	}
+	close(fds[1]);
+	waitpid(pid, NULL, 0);
+  }
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  double usec = std::chrono::duration<double, std::micro>(end - begin).count() / runs;
+  std::cout << "\tStartup Latency (-r)\t" << usec << " usec/process" << std::endl;
+}
+
+/**
+ * @struct SuiteResult
+ * @brief ベンチマークスイートの1項目の計測結果
+ */
+struct SuiteResult{
+  std::string name;                //計測対象の名前
+  size_t size;                     //1回に処理する文字数(0なら文字数によらない操作)
+  unsigned long long iterations;   //繰り返した回数
+  double seconds;                  //繰り返し全体にかかった秒数
+  unsigned long long allocations;  //繰り返し全体でのヒープ領域の確保回数
+  long peakRss;                    //計測中の最大常駐メモリ(KB)
+  bool ok;                         //結果の照合に成功したか
+};
+
+/**
+ * @class NullBuffer
+ * @brief 書き込まれた内容を捨てるストリームバッファ
+ * @detail VisibleEncryptionの変換経過の表示をJSONの出力に混ぜないために用いる
+ */
+class NullBuffer : public std::streambuf{
+protected:
+  int overflow(int c){
+	return c;
+  }
+  std::streamsize xsputn(const char *, std::streamsize n){
+	return n;
+  }
+};
+
+/**
+ * @brief 最大常駐メモリの記録を現在の値に戻す
+ * @param なし
+ * @return なし
+ * @detail /proc/self/clear_refsに5を書くとVmHWMが戻る(Linux 4.0以降).
+ *         書けない環境ではプロセス開始からの最大値のまま計測する
+ */
+void ResetPeakRss(){
+  std::ofstream ofs("/proc/self/clear_refs");
+  ofs << "5";
+}
+
+/**
+ * @brief 最大常駐メモリを返す
+ * @param なし
+ * @return 最大常駐メモリ(KB)
+ */
+long GetPeakRss(){
+  std::ifstream ifs("/proc/self/status");
+  std::string line;
+  while(std::getline(ifs, line)){
+	if(line.compare(0, 6, "VmHWM:") == 0){
+	  return strtol(line.c_str() + 6, NULL, 10);
+	}
+  }
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+/**
+ * @brief 一定時間以上になるまで処理を繰り返して計測する
+ * @param [in] name 計測対象の名前
+ * @param [in] size 1回に処理する文字数(0なら文字数によらない操作)
+ * @param [in] run 1回分の処理を行う関数(照合に成功したらtrueを返す)
+ * @return 計測結果
+ * @detail 短い入力でも時計の分解能に埋もれないよう,合計MIN_SECONDS秒以上になるまで繰り返す
+ */
+template <typename Function>
+SuiteResult MeasureCase(const std::string &name, const size_t size, Function run){
+  static const double MIN_SECONDS = 0.2;
+  SuiteResult result = {name, size, 0, 0.0, 0, 0, true};
+  ResetPeakRss();
+  unsigned long long allocations = GetAllocationCount();
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  do{
+	result.ok = run() && result.ok;
+	result.iterations++;
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+  }while(result.seconds < MIN_SECONDS);
+  result.allocations = GetAllocationCount() - allocations;
+  result.peakRss = GetPeakRss();
+  return result;
+}
+
+/**
+ * @brief 計測結果をJSONのオブジェクトとして書き出す
+ * @param [out] out 出力ストリーム
+ * @param [in] result 計測結果
+ * @return なし
+ * @detail 文字数によらない操作は,1文字あたりの代わりに1回あたりの値を書く
+ */
+void WriteResult(std::ostream &out, const SuiteResult &result){
+  double units = (result.size > 0) ? double(result.size) * result.iterations : double(result.iterations);
+  out << "    {\"name\": \"" << result.name << "\", \"size\": " << result.size
+	  << ", \"iterations\": " << result.iterations << ", \"seconds\": " << result.seconds;
+  if(result.size > 0){
+	out << ", \"chars_per_sec\": " << (units / result.seconds)
+		<< ", \"ns_per_char\": " << (result.seconds * 1e9 / units);
+  }else{
+	out << ", \"ops_per_sec\": " << (units / result.seconds)
+		<< ", \"ns_per_op\": " << (result.seconds * 1e9 / units);
+  }
+  out << ", \"allocations_per_iter\": " << double(result.allocations) / result.iterations
+	  << ", \"peak_rss_kb\": " << result.peakRss
+	  << ", \"ok\": " << (result.ok ? "true" : "false") << "}";
+}
+
+/**
+ * @brief 暗号化したファイルを複号化して元に戻るまでの速度を計る
+ * @param [in] size ファイルの文字数
+ * @return 計測結果
+ * @detail -f/-oと同じStreamEncryptionで暗号化と複号化を1回ずつ行う.
+ *         平文のファイルはブロックごとに書くので,メモリ上に全体を持たない
+ */
+SuiteResult MeasureFileRoundTrip(const size_t size){
+  static const size_t BLOCK_SIZE = 1 << 20;
+  std::string names[3] = {"/tmp/enigma_bench_plainXXXXXX", "/tmp/enigma_bench_cipherXXXXXX",
+						  "/tmp/enigma_bench_decryptXXXXXX"};
+  for(int i = 0; i < 3; i++){
+	int fd = mkstemp(&names[i][0]);
+	if(fd >= 0){
+	  close(fd);
+	}
+  }
+  {
+	std::ofstream ofs(names[0], std::ios::binary);
+	std::string block = MakeText(std::min(size, BLOCK_SIZE));
+	for(size_t done = 0; done < size; done += block.length()){
+	  ofs.write(block.data(), std::min(block.length(), size - done));
+	}
+  }
+  Enigma enigma;
+  SuiteResult result = MeasureCase("FileRoundTrip", size * 2, [&](){
+	for(int i = 0; i < 2; i++){
+	  std::ifstream ifs(names[i], std::ios::binary);
+	  std::ofstream ofs(names[i + 1], std::ios::binary);
+	  enigma.KeySet("ABC");
+	  if(enigma.StreamEncryption(ifs, ofs, 1, NORMAL_MODE) < 0){
+		return false;
+	  }
+	}
+	return true;
+  });
+            
+  /*複号化したファイルが平文と一致するかを照合する*/
+  std::ifstream plain(names[0], std::ios::binary);
+  std::ifstream decrypt(names[2], std::ios::binary);
+  std::vector<char> a(BLOCK_SIZE), b(BLOCK_SIZE);
+  while(result.ok && plain){
+	plain.read(&a[0], BLOCK_SIZE);
+	decrypt.read(&b[0], BLOCK_SIZE);
+	result.ok = plain.gcount() == decrypt.gcount() && std::equal(a.begin(), a.begin() + plain.gcount(), b.begin());
+  }
+  for(int i = 0; i < 3; i++){
+	unlink(names[i].c_str());
+  }
+  return result;
+}
+
+/**
+ * @brief 入力の大きさを変えながら各APIを計測し,結果をJSONで出力する
+ * @param [in] max_size 最大の文字数
+ * @return 終了ステータス
+ * @detail 文字数は16から16倍ずつ変え,最後はmax_sizeとする(既定では16Bから1GBまで).
+ *         変換経過を表示するVisibleEncryptionは1MB,KeyVisibleEncryptionは64KBまでとし,
+ *         表示は捨てる.FileRoundTripのsizeは暗号化と複号化で処理する文字数の合計
+ */
+int RunSuite(const size_t max_size){
+  static const size_t VISIBLE_LIMIT = 1 << 20;
+  static const size_t KEY_VISIBLE_LIMIT = 1 << 16;
+  std::vector<SuiteResult> results;
+  volatile char sink = 0;
+            
+  /*文字数によらない操作*/
+  results.push_back(MeasureCase("Construct(Enigma)", 0, [&](){
+	Enigma enigma;
+	sink = enigma.getState()[0];
+	return true;
+  }));
+  Plugboard plugboard(PLUGBOARD_WIRING);
+  results.push_back(MeasureCase("Construct(EnigmaConfig)", 0, [&](){
+	EnigmaConfig config(plugboard);
+	sink = config.getPlugboard().ToString()[0];
+	return true;
+  }));
+  Enigma enigma;
+  unsigned int k = 0;
+  results.push_back(MeasureCase("KeySet", 0, [&](){
+	k = (k + 1) % RingSet::PERIOD;
+	enigma.KeySet({char('A' + k / 676), char('A' + k / 26 % 26), char('A' + k % 26)});
+	sink = enigma.getCursor().getStartPos(0);
+	return true;
+  }));
+            
+  /*文字数を変えて計測する操作*/
+  NullBuffer null_buffer;
+  for(size_t size = 16; size <= max_size; size = (size < max_size && size * 16 > max_size) ? max_size : size * 16){
+	std::string text = MakeText(size);
+	std::string expected;
+	enigma.KeySet("ABC");
+	results.push_back(MeasureCase("Encryption", size, [&](){
+	  std::string cryptogram = enigma.Encryption(text);
+	  sink = cryptogram[0];
+	  if(expected.empty()){
+		expected.swap(cryptogram);
+	  }
+	  return true;
+	}));
+	std::vector<char> buf(size);
+	enigma.KeySet("ABC");
+	bool first = true;
+	results.push_back(MeasureCase("Encryption(buffer)", size, [&](){
+	  enigma.Encryption(text.data(), size, &buf[0]);
+	  bool ok = !first || std::equal(buf.begin(), buf.end(), expected.begin());
+	  first = false;
+	  return ok;
+	}));
+	std::streambuf *stdout_buffer = std::cout.rdbuf(&null_buffer);
+	if(size <= VISIBLE_LIMIT){
+	  enigma.KeySet("ABC");
+	  first = true;
+	  results.push_back(MeasureCase("VisibleEncryption", size, [&](){
+		bool ok = enigma.VisibleEncryption(text) == expected || !first;
+		first = false;
+		return ok;
+	  }));
+	}
+	if(size <= KEY_VISIBLE_LIMIT){
+	  enigma.KeySet("ABC");
+	  first = true;
+	  results.push_back(MeasureCase("KeyVisibleEncryption", size, [&](){
+		bool ok = enigma.KeyVisibleEncryption(text) == expected || !first;
+		first = false;
+		return ok;
+	  }));
+	}
+	std::cout.rdbuf(stdout_buffer);
+            
+	/*メモリ上の入出力を解放してから,ファイルの往復を計る*/
+	std::string().swap(text);
+	std::string().swap(expected);
+	std::vector<char>().swap(buf);
+	results.push_back(MeasureFileRoundTrip(size));
+  }
+            
+  /*JSONで出力する*/
+  std::cout << "{\n  \"benchmark\": \"enigma_bench\",\n  \"kernel\": " << DetectBatchKernel()
+			<< ",\n  \"max_size\": " << max_size << ",\n  \"results\": [\n";
+  for(size_t i = 0; i < results.size(); i++){
+	WriteResult(std::cout, results[i]);
+	std::cout << ((i + 1 < results.size()) ? ",\n" : "\n");
+  }
+  std::cout << "  ]\n}" << std::endl;
+  return 0;
+}
+
+/**
+ * @brief ベンチマークのエントリポイント
+ * @param [in] argc コマンドライン引数の数
+ * @param [in] argv コマンドライン引数(第1引数に文字数,第2引数にenigmaのパスを指定できる.
+ *             第1引数が--jsonならベンチマークスイートを実行し,第2引数に最大の文字数を指定できる)
+ * @return 終了ステータス
+ */
+int main(int argc, char *argv[]){
+  if(argc > 1 && strcmp(argv[1], "--json") == 0){
+	return RunSuite((argc > 2) ? strtoull(argv[2], NULL, 10) : (1ULL << 30));
+  }
+  size_t length = (argc > 1) ? strtoull(argv[1], NULL, 10) : (1 << 24);
+  std::string text = MakeText(length);
+  std::cout << "\tInput Size -> " << length << " chars\n";
+  std::cout << "\tDetected Kernel -> " << DetectBatchKernel() << " (0:scalar 1:sse4.1 2:avx2)\n";
+
+  std::string expected = Measure("Encryption      ", text, "",
+	[](Enigma &e, const std::string &s){ return e.Encryption(s); });
+  Measure("TableEncryption ", text, expected,
+	[](Enigma &e, const std::string &s){ return e.TableEncryption(s); });
+  Measure("Batch(scalar)   ", text, expected,
+	[](Enigma &e, const std::string &s){ return e.BatchEncryption(s, BATCH_KERNEL_SCALAR); });
+  Measure("Batch(sse4.1)   ", text, expected,
+	[](Enigma &e, const std::string &s){ return e.BatchEncryption(s, BATCH_KERNEL_SSE41); });
+  Measure("Batch(avx2)     ", text, expected,
+	[](Enigma &e, const std::string &s){ return e.BatchEncryption(s, BATCH_KERNEL_AVX2); });
+            
+  /*スレッド数を変えたときのスケーリング*/
+  unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+  std::cout << "\tHardware Threads -> " << cores << "\n";
+  for(unsigned int jobs = 1; jobs <= cores * 2; jobs *= 2){
+	Measure("Parallel(-j " + std::to_string(jobs) + ")   ", text, expected,
+	  [jobs](Enigma &e, const std::string &s){ return e.ParallelEncryption(s, jobs, NORMAL_MODE); });
+	Measure("Parallel(-v -j " + std::to_string(jobs) + ")", text, expected,
+	  [jobs](Enigma &e, const std::string &s){ return e.ParallelEncryption(s, jobs, BATCH_KERNEL_MODE); });
+  }
+        
+  /*短いメッセージの暗号化*/
+  MeasureShortMessages(1000000, 64);
+        
+  /*全キーでの暗号化*/
+  MeasureAllKeys(256);
+        
+  /*n-gramによる採点*/
+  MeasureNgramScoring(length);
+        
+  /*フィルタモードのプロセス起動時間*/
+  MeasureStartup((argc > 2) ? argv[2] : "./enigma", 200);
+  return 0;
+}
@@ -0,0 +1,299 @@
+/**
+ * @brief 長時間の探索の途中経過(チェックポイント)の書き出しと読み込み
+ * @author Hirokazu Kiyomaru
+ * @attention g++ -std=c++11 としてコンパイル
+ * @file enigma_checkpoint.h
+ * @detail チェックポイントは,CheckpointHeaderに続いて探索ごとの内容を並べたバイナリファイル.
+ *         探索の条件(暗号文やオプション)から求めた指紋をヘッダに持ち,条件の違う
+ *         チェックポイントからは再開しない.書き出しは一時ファイルに書いてから名前を
+ *         付け替えるので,書き出しの途中で止められても前のチェックポイントは壊れない
+ */
+#ifndef ENIGMA_CHECKPOINT_H
+#define ENIGMA_CHECKPOINT_H
+
+//C++の標準ライブラリ
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <type_traits>
+
+//チェックポイントのファイルの先頭の識別子
+static const char CHECKPOINT_MAGIC[4] = {'E', 'N', 'C', 'P'};
+//チェックポイントのファイルの形式の版
+static const uint32_t CHECKPOINT_VERSION = 2;
+
+/**
+ * @brief チェックポイントを書き出す探索の種類
+ */
+enum CheckpointKind{
+  CHECKPOINT_KEY_SEARCH = 1,      //暗号文だけからのキーの探索(-a)
+  CHECKPOINT_PLUGBOARD_SEARCH = 2 //プラグボードの探索(-q)
+};
+
+/**
+ * @struct CheckpointHeader
+ * @brief チェックポイントのファイルの先頭(24バイト)
+ */
+struct CheckpointHeader{
+  char magic[4];        //CHECKPOINT_MAGIC
+  uint32_t version;     //CHECKPOINT_VERSION
+  uint32_t kind;        //探索の種類(CheckpointKind)
+  uint32_t reserved;    //0
+  uint64_t fingerprint; //探索の条件の指紋
+};
+
+/**
+ * @brief 探索の条件を表す文字列から指紋を求める(FNV-1a,64ビット)
+ * @param [in] data 探索の条件を並べた文字列
+ * @return 指紋
+ */
+inline uint64_t CheckpointFingerprint(const std::string &data){
+  uint64_t hash = 14695981039346656037ULL;
+  for(size_t i = 0; i < data.length(); i++){
+	hash ^= (unsigned char)data[i];
+	hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+/**
+ * @class CheckpointWriter
+ * @brief チェックポイントの内容をメモリ上に並べ,最後にまとめてファイルに書き出す
+ */
+class CheckpointWriter{
+private:
+  std::string buffer; //書き出す内容
+public:
+  /**
+   * コンストラクタ
+   * @param [in] kind 探索の種類
+   * @param [in] fingerprint 探索の条件の指紋
+   */
+  CheckpointWriter(const CheckpointKind kind, const uint64_t fingerprint) : buffer(){
+	CheckpointHeader header;
+	memcpy(header.magic, CHECKPOINT_MAGIC, 4);
+	header.version = CHECKPOINT_VERSION;
+	header.kind = kind;
+	header.reserved = 0;
+	header.fingerprint = fingerprint;
+	Put(header);
+  }
+
+  /**
+   * @brief 値をそのままのバイト列で並べる
+   * @param [in] value 値(そのままコピーできる型)
+   * @return なし
+   */
+  template <typename T>
+  void Put(const T &value){
+	static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+	buffer.append((const char *)&value, sizeof(T));
+  }
+
+  /**
+   * @brief 長さを付けて文字列を並べる
+   * @param [in] value 文字列
+   * @return なし
+   */
+  void PutString(const std::string &value){
+	Put<uint64_t>(value.length());
+	buffer.append(value);
+  }
+
+  /**
+   * @brief 並べた内容をファイルに書き出す
+   * @param [in] file_name チェックポイントのファイル名
+   * @return 終了ステータス
+   * @detail file_name + ".tmp"に書いてから名前を付け替える
+   */
+  int Commit(const std::string &file_name) const{
+	std::string temp_name = file_name + ".tmp";
+	{
+	  std::ofstream ofs(temp_name, std::ios::binary);
+	  ofs.write(buffer.data(), buffer.length());
+	  ofs.close();
+	  if(ofs.fail()){
+		std::cerr << "\tCannot write the checkpoint. > " << temp_name << std::endl;
+		return -1;
+	  }
+	}
+	if(rename(temp_name.c_str(), file_name.c_str()) < 0){
+	  std::cerr << "\tCannot write the checkpoint. > " << file_name << std::endl;
+	  return -1;
+	}
+	return 0;
+  }
+};
+
+/**
+ * @class CheckpointReader
+ * @brief チェックポイントのファイルを読み,並べた順に値を取り出す
+ */
+class CheckpointReader{
+private:
+  std::string buffer; //読み込んだ内容
+  size_t pos;         //次に取り出す位置
+public:
+  /**
+   * デフォルトコンストラクタ
+   */
+  CheckpointReader() : buffer(), pos(0){
+  }
+
+  /**
+   * @brief チェックポイントのファイルを読み込む
+   * @param [in] file_name チェックポイントのファイル名
+   * @param [in] kind 探索の種類
+   * @param [in] fingerprint 探索の条件の指紋
+   * @return 読み込めたら1,ファイルがなければ0,形式や条件が違えば-1
+   */
+  int Open(const std::string &file_name, const CheckpointKind kind, const uint64_t fingerprint){
+	std::ifstream ifs(file_name, std::ios::binary);
+	if(ifs.fail()){
+	  return 0;
+	}
+	std::ostringstream oss;
+	oss << ifs.rdbuf();
+	buffer = oss.str();
+	pos = 0;
+	CheckpointHeader header;
+	if(!Get(header) || memcmp(header.magic, CHECKPOINT_MAGIC, 4) != 0
+	   || header.version != CHECKPOINT_VERSION || header.kind != (uint32_t)kind){
+	  std::cerr << "\tInvalid checkpoint. > " << file_name << std::endl;
+	  return -1;
+	}
+	if(header.fingerprint != fingerprint){
+	  std::cerr << "\tThe checkpoint was written for another search. > " << file_name << std::endl;
+	  return -1;
+	}
+	return 1;
+  }
+
+  /**
+   * @brief 値を取り出す
+   * @param [out] value 値(そのままコピーできる型)
+   * @return 残りが足りなければfalse
+   */
+  template <typename T>
+  bool Get(T &value){
+	static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+	if(buffer.length() - pos < sizeof(T)){
+	  return false;
+	}
+	memcpy(&value, buffer.data() + pos, sizeof(T));
+	pos += sizeof(T);
+	return true;
+  }
+
+  /**
+   * @brief 長さを付けて並べた文字列を取り出す
+   * @param [out] value 文字列
+   * @return 残りが足りなければfalse
+   */
+  bool GetString(std::string &value){
+	uint64_t length = 0;
+	if(!Get(length) || buffer.length() - pos < length){
+	  return false;
+	}
+	value.assign(buffer, pos, length);
+	pos += length;
+	return true;
+  }
+};
+
+/**
+ * @class CheckpointTimer
+ * @brief チェックポイントを書き出す間隔を計り,書き出しにかかった時間を数える
+ */
+class CheckpointTimer{
+private:
+  std::string fileName;     //チェックポイントのファイル名(空なら書き出さない)
+  double interval;          //書き出す間隔(秒)
+  std::chrono::steady_clock::time_point last; //最後に書き出した(または探索を始めた)時刻
+  unsigned long long count; //書き出した回数
+  double seconds;           //書き出しにかかった秒数の合計
+public:
+  /**
+   * デフォルトコンストラクタ
+   */
+  CheckpointTimer() : fileName(), interval(0.0), last(), count(0), seconds(0.0){
+  }
+
+  /**
+   * @brief 書き出し先と間隔を設定する
+   * @param [in] file_name チェックポイントのファイル名
+   * @param [in] interval 書き出す間隔(秒)
+   * @return なし
+   */
+  void Set(const std::string &file_name, const double interval){
+	fileName = file_name;
+	this->interval = interval;
+  }
+
+  /**
+   * @brief 間隔を計り始める
+   * @param なし
+   * @return なし
+   */
+  void Start(){
+	last = std::chrono::steady_clock::now();
+  }
+
+  /**
+   * @brief 書き出すかどうかを返す
+   * @param なし
+   * @return 書き出し先が設定されていればtrue
+   */
+  inline bool Enabled() const{
+	return !fileName.empty();
+  }
+
+  /**
+   * @brief 書き出す時刻になったかを返す
+   * @param なし
+   * @return 最後に書き出してから間隔以上経っていればtrue
+   */
+  bool Due() const{
+	return Enabled() && std::chrono::duration<double>(std::chrono::steady_clock::now() - last).count() >= interval;
+  }
+
+  /**
+   * @brief チェックポイントを書き出し,かかった時間を数える
+   * @param [in] fill 書き出す内容を並べたCheckpointWriterを返す関数
+   * @return 終了ステータス
+   * @detail 内容を並べる時間も書き出しにかかった時間に含める
+   */
+  template <typename Function>
+  int Write(Function fill){
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	int status = fill().Commit(fileName);
+	last = std::chrono::steady_clock::now();
+	seconds += std::chrono::duration<double>(last - begin).count();
+	count++;
+	return status;
+  }
+
+  /**
+   * @brief countに対するgetアクセサ
+   * @param なし
+   * @return 書き出した回数
+   */
+  inline unsigned long long getCount() const{
+	return count;
+  }
+
+  /**
+   * @brief secondsに対するgetアクセサ
+   * @param なし
+   * @return 書き出しにかかった秒数の合計
+   */
+  inline double getSeconds() const{
+	return seconds;
+  }
+};
+
+#endif // ENIGMA_CHECKPOINT_H
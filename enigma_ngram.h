@@ -0,0 +1,361 @@
+/**
+ * @brief 英文のn-gramの出現頻度による平文らしさの採点
+ * @author Hirokazu Kiyomaru
+ * @attention g++ -std=c++11 としてコンパイル
+ * @file enigma_ngram.h
+ * @detail n-gram(2~4文字)の出現確率の対数を,アルファベットのID(Alpha2AlphaID)を
+ *         26進数とみなした番号で引く平坦な配列として持つ.
+ *         配列は英文から数えるか,あらかじめ書き出したバイナリファイルをmmapで読む.
+ *         バイナリファイルの形式は,NgramFileHeaderに続いて2文字から4文字までの
+ *         配列(26^n要素のfloat)を順に並べたもの
+ */
+#ifndef ENIGMA_NGRAM_H
+#define ENIGMA_NGRAM_H
+
+//C++の標準ライブラリ
+#include <math.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "enigma.h"
+
+//n-gramのバイナリファイルの先頭の識別子
+static const char NGRAM_FILE_MAGIC[4] = {'E', 'N', 'G', 'M'};
+//n-gramのバイナリファイルの形式の版
+static const uint32_t NGRAM_FILE_VERSION = 1;
+//n-gramの文字数の範囲
+static const int NGRAM_MIN_ORDER = 2;
+static const int NGRAM_MAX_ORDER = 4;
+
+/**
+ * @struct NgramFileHeader
+ * @brief n-gramのバイナリファイルの先頭(16バイト)
+ */
+struct NgramFileHeader{
+  char magic[4];       //NGRAM_FILE_MAGIC
+  uint32_t version;    //NGRAM_FILE_VERSION
+  uint32_t firstOrder; //最初の配列のn-gramの文字数
+  uint32_t lastOrder;  //最後の配列のn-gramの文字数
+};
+
+/**
+ * @brief 26のorder乗を求める
+ * @param [in] order n-gramの文字数
+ * @return n-gramの種類の数
+ */
+inline size_t NgramSize(const int order){
+  size_t size = 1;
+  for(int i = 0; i < order; i++){
+	size *= 26;
+  }
+  return size;
+}
+
+/**
+ * @class NgramModel
+ * @brief 英文のn-gramの出現確率の対数を,アルファベットのIDを26進数とみなした番号で引く
+ * @detail 英文から数えた場合は自分で配列を持ち,バイナリファイルを読んだ場合は
+ *         mmapした領域をそのまま引く
+ */
+class NgramModel{
+private:
+  int order;               //n-gramの文字数
+  size_t high;             //26^(order - 1)(先頭の文字の桁の重み)
+  const float *logp;       //n-gramの出現確率の対数(log10,26^order要素)
+  std::vector<float> owned;//英文から数えた場合の配列
+  void *mapped;            //mmapした領域(読んでいなければNULL)
+  size_t mappedLength;     //mmapした領域のバイト数
+  DISALLOW_COPY_AND_ASSIGN(NgramModel);
+
+  /**
+   * @brief 英文のファイルからn-gramを数え,出現確率の対数の配列を作る
+   * @param [in] file_name 英文のファイル名(アルファベット以外の文字は読み飛ばす)
+   * @param [in] order n-gramの文字数
+   * @param [out] table 出現確率の対数(26^order要素)
+   * @return 終了ステータス
+   * @detail 一度も現れないn-gramには0.01回現れたものとして確率を与える
+   */
+  static int Count(const std::string &file_name, const int order, std::vector<float> &table){
+	std::ifstream ifs(file_name);
+	if(ifs.fail()){
+	  std::cerr << "\tFile cannot open. > " << file_name << std::endl;
+	  return -1;
+	}
+	size_t size = NgramSize(order);
+	std::vector<unsigned int> counts(size, 0);
+	unsigned long long total = 0;
+	size_t index = 0;
+	int filled = 0;
+	char c;
+	while(ifs.get(c)){
+	  /*英字だけを数える(UTF-8の多バイト文字などASCII以外のバイトは読み飛ばす)*/
+	  if(c >= 'a' && c <= 'z'){
+		c = c - 'a' + 'A';
+	  }else if(c < 'A' || c > 'Z'){
+		continue;
+	  }
+	  index = (index * 26 + Alpha2AlphaID(c)) % size;
+	  if(++filled >= order){
+		counts[index]++;
+		total++;
+	  }
+	}
+	if(total == 0){
+	  std::cerr << "\tNo letters in the file. > " << file_name << std::endl;
+	  return -1;
+	}
+	table.resize(size);
+	for(size_t i = 0; i < size; i++){
+	  table[i] = log10((counts[i] > 0 ? counts[i] : 0.01) / (double)total);
+	}
+	return 0;
+  }
+
+  /**
+   * @brief mmapした領域を解放する
+   * @param なし
+   * @return なし
+   */
+  void Unmap(){
+	if(mapped != NULL){
+	  munmap(mapped, mappedLength);
+	  mapped = NULL;
+	  mappedLength = 0;
+	}
+  }
+
+  /**
+   * @brief 文字をアルファベットのIDにする
+   * @param [in] code 文字(大文字アルファベット以外はIDを0とする)
+   * @return アルファベットのID
+   */
+  static inline unsigned int ToID(const char code){
+	return Alpha2AlphaID(code);
+  }
+
+  /**
+   * @brief アルファベットのIDをそのまま返す
+   * @param [in] id アルファベットのID
+   * @return アルファベットのID
+   */
+  static inline unsigned int ToID(const uint8_t id){
+	return id;
+  }
+
+  /**
+   * @brief 番号を1文字ずつずらしながら全てのn-gramの出現確率の対数を足し合わせる
+   * @param [in] text 文字かアルファベットのIDの列
+   * @param [in] length 文字数
+   * @return 出現確率の対数の和
+   * @detail 先頭の文字の桁を引いて26倍し,次の文字を足すので,n-gramごとに番号を計算し直さない
+   */
+  template <typename T>
+  double Rolling(const T *text, const size_t length) const{
+	if(order == 0 || length < (size_t)order){
+	  return 0.0;
+	}
+	size_t index = 0;
+	for(int i = 0; i < order; i++){
+	  index = index * 26 + ToID(text[i]);
+	}
+	double sum = logp[index];
+	for(size_t i = order; i < length; i++){
+	  index = (index - ToID(text[i - order]) * high) * 26 + ToID(text[i]);
+	  sum += logp[index];
+	}
+	return sum;
+  }
+public:
+  /**
+   * デフォルトコンストラクタ
+   */
+  NgramModel() : order(0), high(0), logp(NULL), owned(), mapped(NULL), mappedLength(0){
+  }
+
+  /**
+   * デストラクタ
+   */
+  ~NgramModel(){
+	Unmap();
+  }
+
+  /**
+   * @brief 英文のファイルからn-gramを数える
+   * @param [in] file_name 英文のファイル名(アルファベット以外の文字は読み飛ばす)
+   * @param [in] order n-gramの文字数(2~4)
+   * @return 終了ステータス
+   */
+  int Train(const std::string &file_name, const int order){
+	if(order < NGRAM_MIN_ORDER || order > NGRAM_MAX_ORDER){
+	  std::cerr << "\t" << order << " is invalid n-gram order!" << std::endl;
+	  return -1;
+	}
+	if(Count(file_name, order, owned) < 0){
+	  return -1;
+	}
+	Unmap();
+	this->order = order;
+	high = NgramSize(order - 1);
+	logp = owned.data();
+	return 0;
+  }
+
+  /**
+   * @brief バイナリファイルをmmapし,その中のn-gramの配列を引けるようにする
+   * @param [in] file_name バイナリファイル名(Buildで書き出したもの)
+   * @param [in] order n-gramの文字数(2~4)
+   * @return 終了ステータス
+   */
+  int Load(const std::string &file_name, const int order){
+	int fd = open(file_name.c_str(), O_RDONLY);
+	if(fd < 0){
+	  std::cerr << "\tFile cannot open. > " << file_name << std::endl;
+	  return -1;
+	}
+	struct stat st;
+	if(fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(NgramFileHeader)){
+	  close(fd);
+	  std::cerr << "\tInvalid n-gram file. > " << file_name << std::endl;
+	  return -1;
+	}
+	void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED){
+	  std::cerr << "\tFile cannot map. > " << file_name << std::endl;
+	  return -1;
+	}
+
+	/*ヘッダを確かめ,orderの配列の位置を求める*/
+	const NgramFileHeader *header = (const NgramFileHeader *)map;
+	size_t offset = sizeof(NgramFileHeader);
+	for(int n = header->firstOrder; n < order; n++){
+	  offset += NgramSize(n) * sizeof(float);
+	}
+	if(memcmp(header->magic, NGRAM_FILE_MAGIC, 4) != 0 || header->version != NGRAM_FILE_VERSION
+	   || order < (int)header->firstOrder || order > (int)header->lastOrder
+	   || offset + NgramSize(order) * sizeof(float) > (size_t)st.st_size){
+	  munmap(map, st.st_size);
+	  std::cerr << "\tInvalid n-gram file. > " << file_name << std::endl;
+	  return -1;
+	}
+	Unmap();
+	owned.clear();
+	mapped = map;
+	mappedLength = st.st_size;
+	this->order = order;
+	high = NgramSize(order - 1);
+	logp = (const float *)((const char *)map + offset);
+	return 0;
+  }
+
+  /**
+   * @brief ファイルの形式を見て,バイナリファイルならLoad,そうでなければTrainする
+   * @param [in] file_name バイナリファイルか英文のファイルの名前
+   * @param [in] order n-gramの文字数(2~4)
+   * @return 終了ステータス
+   */
+  int Open(const std::string &file_name, const int order){
+	char magic[4] = {0, 0, 0, 0};
+	std::ifstream ifs(file_name, std::ios::binary);
+	ifs.read(magic, 4);
+	if(memcmp(magic, NGRAM_FILE_MAGIC, 4) == 0){
+	  return Load(file_name, order);
+	}
+	return Train(file_name, order);
+  }
+
+  /**
+   * @brief 英文のファイルから2~4文字のn-gramを数え,バイナリファイルに書き出す
+   * @param [in] corpus_name 英文のファイル名
+   * @param [in] file_name 書き出すバイナリファイル名
+   * @return 終了ステータス
+   */
+  static int Build(const std::string &corpus_name, const std::string &file_name){
+	std::vector<std::vector<float> > tables(NGRAM_MAX_ORDER + 1);
+	for(int n = NGRAM_MIN_ORDER; n <= NGRAM_MAX_ORDER; n++){
+	  if(Count(corpus_name, n, tables[n]) < 0){
+		return -1;
+	  }
+	}
+	std::ofstream ofs(file_name, std::ios::binary);
+	if(ofs.fail()){
+	  std::cerr << "\tFile cannot open. > " << file_name << std::endl;
+	  return -1;
+	}
+	NgramFileHeader header;
+	memcpy(header.magic, NGRAM_FILE_MAGIC, 4);
+	header.version = NGRAM_FILE_VERSION;
+	header.firstOrder = NGRAM_MIN_ORDER;
+	header.lastOrder = NGRAM_MAX_ORDER;
+	ofs.write((const char *)&header, sizeof(header));
+	for(int n = NGRAM_MIN_ORDER; n <= NGRAM_MAX_ORDER; n++){
+	  ofs.write((const char *)tables[n].data(), tables[n].size() * sizeof(float));
+	}
+	ofs.close();
+	if(ofs.fail()){
+	  std::cerr << "\tCannot write the output." << std::endl;
+	  return -1;
+	}
+	return 0;
+  }
+
+  /**
+   * @brief orderに対するgetアクセサ
+   * @param なし
+   * @return n-gramの文字数(まだ読んでいなければ0)
+   */
+  inline int getOrder() const{
+	return order;
+  }
+
+  /**
+   * @brief ids[0]から始まるn-gramの出現確率の対数を引く
+   * @param [in] ids アルファベットのID(order文字以上)
+   * @return 出現確率の対数(log10)
+   */
+  inline float LogProb(const uint8_t *ids) const{
+	size_t index = 0;
+	for(int i = 0; i < order; i++){
+	  index = index * 26 + ids[i];
+	}
+	return logp[index];
+  }
+
+  /**
+   * @brief アルファベットのIDの列に含まれる全てのn-gramの出現確率の対数の和を求める
+   * @param [in] ids アルファベットのID
+   * @param [in] length 文字数
+   * @return 出現確率の対数の和(大きいほど英文らしい)
+   */
+  double Score(const uint8_t *ids, const size_t length) const{
+	return Rolling(ids, length);
+  }
+
+  /**
+   * @brief 文字列に含まれる全てのn-gramの出現確率の対数の和を求める
+   * @param [in] text 大文字アルファベットの列(Encryptionの出力をそのまま渡せる)
+   * @param [in] length 文字数
+   * @return 出現確率の対数の和(大きいほど英文らしい)
+   */
+  double Score(const char *text, const size_t length) const{
+	return Rolling(text, length);
+  }
+
+  /**
+   * @brief 文字列に含まれる全てのn-gramの出現確率の対数の和を求める
+   * @param [in] text 大文字アルファベットの列(Encryptionの出力をそのまま渡せる)
+   * @return 出現確率の対数の和(大きいほど英文らしい)
+   */
+  double Score(const std::string &text) const{
+	return Rolling(text.data(), text.length());
+  }
+};
+
+#endif // ENIGMA_NGRAM_H
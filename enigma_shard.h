@@ -0,0 +1,397 @@
+/**
+ * @brief キーの探索を複数のプロセスに分けて行う
+ * @author Hirokazu Kiyomaru
+ * @attention g++ -std=c++11 としてコンパイル
+ * @file enigma_shard.h
+ * @detail キーの探索の仕事(KeySearchの仕事の番号)を連続した範囲(シャード)に分け,
+ *         forkしたワーカープロセスに1つずつ割り当てる.ワーカーは探索した候補をパイプで
+ *         コーディネーター(親プロセス)に送り,最後に終了の記録を送って終わる.
+ *         終了の記録を送らずに終わった(クラッシュした)ワーカーのシャードは,
+ *         送られていた候補を捨てて別のワーカーに割り当て直す
+ */
+#ifndef ENIGMA_SHARD_H
+#define ENIGMA_SHARD_H
+
+//C++の標準ライブラリ
+#include <signal.h>
+#include <errno.h>
+#include <string.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <iostream>
+#include <chrono>
+
+#include "enigma.h"
+#include "enigma_attack.h"
+
+/**
+ * @brief ワーカーからコーディネーターに送る記録の種類
+ */
+enum ShardRecordType{
+  SHARD_RECORD_CANDIDATE = 1, //キーの候補
+  SHARD_RECORD_DONE = 2       //シャードの探索を終えた
+};
+
+/**
+ * @struct ShardRecord
+ * @brief ワーカーからコーディネーターにパイプで送る記録(24バイト)
+ */
+struct ShardRecord{
+  uint32_t type;     //記録の種類(ShardRecordType)
+  uint32_t keyIndex; //候補のキーの番号
+  double score;      //候補の点数
+  uint64_t searched; //探索を終えたときの,採点したキーの数
+};
+
+/**
+ * @struct Shard
+ * @brief ワーカーに割り当てる仕事の範囲[firstUnit, lastUnit)
+ */
+struct Shard{
+  unsigned int firstUnit; //最初の仕事の番号
+  unsigned int lastUnit;  //最後の仕事の次の番号
+  unsigned int attempts;  //割り当てた回数
+};
+
+/**
+ * @class ShardCoordinator
+ * @brief ワーカープロセスにシャードを割り当て,送られた候補をまとめる
+ */
+class ShardCoordinator{
+private:
+  /**
+   * @struct Worker
+   * @brief 動いているワーカープロセス
+   */
+  struct Worker{
+	pid_t pid;                          //プロセスID
+	int fd;                             //結果を読むパイプ
+	Shard shard;                        //割り当てたシャード
+	std::string buffer;                 //読んだが記録にまとまっていないバイト列
+	std::vector<ShardRecord> records;   //読んだ記録
+  };
+
+  const EnigmaConfig *config;       //配線
+  std::string code;                 //暗号文
+  unsigned long long offset;        //暗号文の先頭がキーを合わせてから何文字目か
+  ScoreType type;                   //採点方法
+  unsigned int candidates;          //返す候補の数
+  double threshold;                 //この点数以上の候補が見つかったら打ち切る(0以下なら打ち切らない)
+  unsigned int jobs;                //1つのワーカーのスレッド数
+  unsigned int processes;           //同時に動かすワーカーの数
+  std::deque<Shard> pending;        //まだ割り当てていないシャード
+  std::vector<Worker> workers;      //動いているワーカー
+  std::vector<Candidate> best;      //点数の高い順に並んだ候補
+  unsigned long long searched;      //採点したキーの数
+  unsigned int shards;              //シャードの数
+  unsigned int reassigned;          //割り当て直した回数
+  bool stopped;                     //打ち切ったらtrue
+  DISALLOW_COPY_AND_ASSIGN(ShardCoordinator);
+
+  /**
+   * @brief バッファの内容をすべて書き出す
+   * @param [in] fd 出力のファイル記述子
+   * @param [in] buf 書き出す内容
+   * @param [in] length バイト数
+   * @return 終了ステータス
+   */
+  static int WriteAll(const int fd, const char *buf, size_t length){
+	while(length > 0){
+	  ssize_t n = write(fd, buf, length);
+	  if(n < 0){
+		if(errno == EINTR){
+		  continue;
+		}
+		return -1;
+	  }
+	  buf += n;
+	  length -= n;
+	}
+	return 0;
+  }
+
+  /**
+   * @brief ワーカープロセスの中でシャードを探索し,結果をパイプに書き出して終了する
+   * @param [in] shard 割り当てられたシャード
+   * @param [in] fd 結果を書くパイプ
+   * @return なし(戻らない)
+   */
+  [[noreturn]] void RunWorker(const Shard &shard, const int fd) const{
+	KeySearch search(*config, code, offset, type, candidates, threshold, jobs);
+	std::vector<Candidate> result = search.Run(shard.firstUnit, shard.lastUnit);
+	std::vector<ShardRecord> records;
+	for(size_t i = 0; i < result.size(); i++){
+	  ShardRecord record = {SHARD_RECORD_CANDIDATE, result[i].keyIndex, result[i].score, 0};
+	  records.push_back(record);
+	}
+	ShardRecord done = {SHARD_RECORD_DONE, 0, 0.0, search.getSearched()};
+	records.push_back(done);
+	int status = WriteAll(fd, (const char *)records.data(), records.size() * sizeof(ShardRecord));
+	close(fd);
+	_exit(status < 0 ? 1 : 0); //親のstdioのバッファを書き出さないよう_exitで終わる
+  }
+
+  /**
+   * @brief シャードをワーカープロセスに割り当てる
+   * @param [in] shard シャード
+   * @return 終了ステータス
+   */
+  int Spawn(Shard shard){
+	int fds[2];
+	if(pipe(fds) < 0){
+	  perror("pipe");
+	  return -1;
+	}
+	shard.attempts++;
+	std::cout.flush();
+	pid_t pid = fork();
+	if(pid < 0){
+	  perror("fork");
+	  close(fds[0]);
+	  close(fds[1]);
+	  return -1;
+	}
+	if(pid == 0){
+	  close(fds[0]);
+	  for(size_t i = 0; i < workers.size(); i++){
+		close(workers[i].fd);
+	  }
+	  RunWorker(shard, fds[1]);
+	}
+	close(fds[1]);
+	Worker worker;
+	worker.pid = pid;
+	worker.fd = fds[0];
+	worker.shard = shard;
+	workers.push_back(worker);
+	return 0;
+  }
+
+  /**
+   * @brief 終わったワーカーの結果をまとめるか,シャードを割り当て直す
+   * @param [in] worker パイプを読み終えたワーカー
+   * @return 終了ステータス(割り当て直す回数が上限を超えたら-1)
+   */
+  int Finish(const Worker &worker){
+	int status = 0;
+	while(waitpid(worker.pid, &status, 0) < 0 && errno == EINTR){
+	}
+	bool completed = WIFEXITED(status) && WEXITSTATUS(status) == 0 && worker.buffer.empty()
+	  && !worker.records.empty() && worker.records.back().type == SHARD_RECORD_DONE;
+	if(!completed){
+	  if(stopped){
+		return 0; //打ち切りで止めたワーカー
+	  }
+	  std::cerr << "\tWorker " << worker.pid << " (units " << worker.shard.firstUnit << "-"
+				<< worker.shard.lastUnit << ") died, reassigning the shard." << std::endl;
+	  if(worker.shard.attempts >= MAX_ATTEMPTS){
+		std::cerr << "\tThe shard failed " << MAX_ATTEMPTS << " times." << std::endl;
+		return -1;
+	  }
+	  reassigned++;
+	  pending.push_front(worker.shard);
+	  return 0;
+	}
+	for(size_t i = 0; i + 1 < worker.records.size(); i++){
+	  Candidate candidate = {worker.records[i].score, worker.records[i].keyIndex};
+	  PushCandidate(best, candidate, candidates);
+	  if(threshold > 0.0 && candidate.score >= threshold){
+		stopped = true;
+	  }
+	}
+	searched += worker.records.back().searched;
+	return 0;
+  }
+
+  /**
+   * @brief 動いているワーカーを全て止める
+   * @param なし
+   * @return なし
+   */
+  void KillAll(){
+	for(size_t i = 0; i < workers.size(); i++){
+	  kill(workers[i].pid, SIGKILL);
+	}
+  }
+public:
+  static const unsigned int MAX_ATTEMPTS = 3;    //1つのシャードを割り当てる回数の上限
+  static const unsigned int SHARDS_PER_PROCESS = 4; //ワーカー1つあたりのシャードの数
+
+  /**
+   * コンストラクタ
+   * @param [in] config 配線
+   * @param [in] code 暗号文(大文字アルファベット)
+   * @param [in] offset 暗号文の先頭がキーを合わせてから何文字目か
+   * @param [in] type 採点方法
+   * @param [in] candidates 返す候補の数
+   * @param [in] threshold この点数以上の候補が見つかったら打ち切る(0以下なら打ち切らない)
+   * @param [in] jobs 1つのワーカーのスレッド数
+   * @param [in] processes 同時に動かすワーカーの数
+   */
+  ShardCoordinator(const EnigmaConfig &config, const std::string &code, const unsigned long long offset,
+				   const ScoreType type, const unsigned int candidates, const double threshold,
+				   const unsigned int jobs, const unsigned int processes)
+	: config(&config), code(code), offset(offset), type(type), candidates(std::max(1u, candidates)),
+	  threshold(threshold), jobs(std::max(1u, jobs)), processes(std::max(1u, processes)),
+	  pending(), workers(), best(), searched(0), shards(0), reassigned(0), stopped(false){
+	/*仕事の範囲をワーカーの数のSHARDS_PER_PROCESS倍に等分する*/
+	shards = std::min(KeySearch::UNITS, this->processes * SHARDS_PER_PROCESS);
+	for(unsigned int i = 0; i < shards; i++){
+	  Shard shard = {KeySearch::UNITS * i / shards, KeySearch::UNITS * (i + 1) / shards, 0};
+	  pending.push_back(shard);
+	}
+  }
+
+  /**
+   * @brief 全てのシャードを探索する
+   * @param なし
+   * @return 点数の高い順に並んだ候補(candidates個まで).失敗したら空
+   */
+  std::vector<Candidate> Run(){
+	int status = 0;
+	while(status == 0 && (!workers.empty() || (!pending.empty() && !stopped))){
+	  /*空いているワーカーの枠にシャードを割り当てる*/
+	  while(status == 0 && !stopped && !pending.empty() && workers.size() < processes){
+		Shard shard = pending.front();
+		pending.pop_front();
+		status = Spawn(shard);
+	  }
+
+	  /*どれかのワーカーから結果が届くまで待つ*/
+	  std::vector<struct pollfd> fds(workers.size());
+	  for(size_t i = 0; i < workers.size(); i++){
+		fds[i].fd = workers[i].fd;
+		fds[i].events = POLLIN;
+		fds[i].revents = 0;
+	  }
+	  if(poll(fds.data(), fds.size(), -1) < 0){
+		if(errno == EINTR){
+		  continue;
+		}
+		perror("poll");
+		status = -1;
+		break;
+	  }
+
+	  /*届いたバイト列を記録にまとめ,パイプが閉じたワーカーを片付ける*/
+	  for(size_t i = fds.size(); i-- > 0;){
+		if(fds[i].revents == 0){
+		  continue;
+		}
+		Worker &worker = workers[i];
+		char buf[4096];
+		ssize_t n = read(worker.fd, buf, sizeof(buf));
+		if(n < 0 && errno == EINTR){
+		  continue;
+		}
+		if(n > 0){
+		  worker.buffer.append(buf, n);
+		  size_t whole = worker.buffer.length() / sizeof(ShardRecord) * sizeof(ShardRecord);
+		  for(size_t pos = 0; pos < whole; pos += sizeof(ShardRecord)){
+			ShardRecord record;
+			memcpy(&record, worker.buffer.data() + pos, sizeof(ShardRecord));
+			worker.records.push_back(record);
+		  }
+		  worker.buffer.erase(0, whole);
+		  continue;
+		}
+		close(worker.fd);
+		if(Finish(worker) < 0){
+		  status = -1;
+		}
+		workers.erase(workers.begin() + i);
+		if(stopped){
+		  KillAll();
+		}
+	  }
+	}
+	if(status < 0){
+	  KillAll();
+	  for(size_t i = 0; i < workers.size(); i++){
+		close(workers[i].fd);
+		waitpid(workers[i].pid, NULL, 0);
+	  }
+	  workers.clear();
+	  best.clear();
+	}
+	return best;
+  }
+
+  /**
+   * @brief searchedに対するgetアクセサ
+   * @param なし
+   * @return 採点したキーの数(探索を終えたシャードの分)
+   */
+  inline unsigned long long getSearched() const{
+	return searched;
+  }
+
+  /**
+   * @brief stoppedに対するgetアクセサ
+   * @param なし
+   * @return しきい値に達して打ち切ったならtrue
+   */
+  inline bool getStopped() const{
+	return stopped;
+  }
+
+  /**
+   * @brief shardsに対するgetアクセサ
+   * @param なし
+   * @return シャードの数
+   */
+  inline unsigned int getShards() const{
+	return shards;
+  }
+
+  /**
+   * @brief reassignedに対するgetアクセサ
+   * @param なし
+   * @return クラッシュしたワーカーのシャードを割り当て直した回数
+   */
+  inline unsigned int getReassigned() const{
+	return reassigned;
+  }
+};
+
+/**
+ * @brief 暗号文だけからキーを複数のプロセスで探索し,上位の候補を表示する(-a -N)
+ * @param [in] config 配線
+ * @param [in] arguments 引数情報を格納しているオブジェクト(暗号文,-n,-c,-e,-g,-j,-N を見る)
+ * @return 終了ステータス
+ */
+inline int ShardExecute(const EnigmaConfig &config, const Arguments &arguments){
+  if(!arguments.getCheckpoint().empty()){
+	std::cerr << "\t-C cannot be used with -N (a crashed shard is searched again instead)." << std::endl;
+	return -1;
+  }
+  std::string code = arguments.getCode();
+  ShardCoordinator coordinator(config, code, arguments.getOffset(), (ScoreType)arguments.getScore(),
+							   arguments.getCandidates(), arguments.getThreshold(), arguments.getJobs(),
+							   arguments.getProcesses());
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  std::vector<Candidate> best = coordinator.Run();
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  double sec = std::chrono::duration<double>(end - begin).count();
+  if(best.empty()){
+	std::cerr << "\tThe sharded search failed." << std::endl;
+	return -1;
+  }
+
+  /*結果出力*/
+  std::cout << "\tAttack Result\n";
+  ShowCandidates(config, code, arguments.getOffset(), best);
+  std::cout << "\t  -Searched Keys -> " << coordinator.getSearched() << " / " << RingSet::PERIOD
+			<< (coordinator.getStopped() ? " (stopped at the threshold)" : "") << "\n";
+  std::cout << "\t  -Workers -> " << arguments.getProcesses() << " processes, "
+			<< coordinator.getShards() << " shards, " << coordinator.getReassigned() << " reassigned\n";
+  std::cout << "\t  -Elapsed Time -> " << sec << " sec" << std::endl;
+  return 0;
+}
+
+#endif // ENIGMA_SHARD_H
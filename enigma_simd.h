@@ -0,0 +1,658 @@
+/**
+ * @brief エニグマの一括暗号化カーネル(SIMD)
+ * @author Hirokazu Kiyomaru
+ * @attention g++ -std=c++11 としてコンパイル
+ * @file enigma_simd.h
+ * @detail 各段の換字表(26要素)をバイトシャッフルで引き,複数の位置を同時に暗号化する.
+ *         x86ではAVX2(32文字)/SSE4.1(16文字)を実行時に選択し,それ以外はスカラで処理する
+ */
+#ifndef ENIGMA_SIMD_H
+#define ENIGMA_SIMD_H
+
+//C++の標準ライブラリ
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ENIGMA_SIMD_X86
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief 一括暗号化カーネルの種類
+ */
+enum BatchKernel{
+  BATCH_KERNEL_SCALAR = 0, //スカラ(1文字ずつ)
+  BATCH_KERNEL_SSE41 = 1,  //SSE4.1(16文字ずつ)
+  BATCH_KERNEL_AVX2 = 2    //AVX2(32文字ずつ)
+};
+
+/**
+ * @struct BatchTables
+ * @brief 一括暗号化カーネルに渡す換字表とスクランブラーの初期位置
+ * @detail 表はバイトシャッフルで16要素ずつ読めるよう32バイトに詰める.
+ *         キーを合わせてからn文字目のringiの位置は(start[i] + n / 26^i) mod 26
+ */
+struct BatchTables{
+  uint8_t plugboard[32];       //プラグボード(行き)
+  uint8_t plugboardInverse[32];//プラグボード(帰り)
+  uint8_t rotor[3][32];        //ring1~3の位置0での配線(行き)
+  uint8_t rotorInverse[3][32]; //ring1~3の位置0での配線の逆写像(帰り)
+  uint8_t reflector[32];       //リフレクター
+  uint8_t start[3];            //キーを合わせた直後のring1~3の位置
+};
+
+/**
+ * @brief スカラで一括暗号化を行う
+ * @param [in] t 換字表
+ * @param [in] in 入力(アルファベットのID)
+ * @param [out] out 出力(アルファベットのID)
+ * @param [in] len 文字数
+ * @param [in] offset 先頭の文字がキーを合わせてから何文字目か
+ * @return なし
+ */
+inline void ScalarBatchEncipher(const BatchTables &t, const uint8_t *in, uint8_t *out,
+								size_t len, unsigned long long offset){
+  unsigned int c1 = offset % 26;         //ring1の回転数(ring2を回すまで)
+  unsigned int c2 = (offset / 26) % 26;  //ring2の回転数(ring3を回すまで)
+  unsigned int p1 = (t.start[0] + c1) % 26;
+  unsigned int p2 = (t.start[1] + c2) % 26;
+  unsigned int p3 = (t.start[2] + (offset / 676)) % 26;
+  for(size_t i = 0; i < len; i++){
+	unsigned int x = t.plugboard[in[i]];
+	x = t.rotor[0][(x + 26 - p1) % 26];
+	x = t.rotor[1][(x + 26 - p2) % 26];
+	x = t.rotor[2][(x + 26 - p3) % 26];
+	x = t.reflector[x];
+	x = (t.rotorInverse[2][x] + p3) % 26;
+	x = (t.rotorInverse[1][x] + p2) % 26;
+	x = (t.rotorInverse[0][x] + p1) % 26;
+	out[i] = t.plugboardInverse[x];
+
+	/*オドメータ式にスクランブラーを進める*/
+	if(++p1 == 26) p1 = 0;
+	if(++c1 == 26){
+	  c1 = 0;
+	  if(++p2 == 26) p2 = 0;
+	  if(++c2 == 26){
+		c2 = 0;
+		if(++p3 == 26) p3 = 0;
+	  }
+	}
+  }
+}
+
+/**
+ * @brief スカラで1つの文字列を複数のキーで一度に暗号化する
+ * @param [in] t 換字表(startは使わない)
+ * @param [in] starts キーごとのキーを合わせた直後のring1~3の位置(keys要素)
+ * @param [in] keys キーの数
+ * @param [in] in 入力(アルファベットのID)
+ * @param [in] len 文字数
+ * @param [in] offset 先頭の文字がキーを合わせてから何文字目か
+ * @param [out] out 出力(アルファベットのID).i文字目のキーkの結果をout[i * stride + k]に置く
+ * @param [in] stride 出力の1文字あたりのバイト数
+ * @return なし
+ */
+inline void ScalarMultiKeyEncipher(const BatchTables &t, const uint8_t (*starts)[3], size_t keys,
+								   const uint8_t *in, size_t len, unsigned long long offset,
+								   uint8_t *out, size_t stride){
+  for(size_t k = 0; k < keys; k++){
+	unsigned int c1 = offset % 26;
+	unsigned int c2 = (offset / 26) % 26;
+	unsigned int p1 = (starts[k][0] + c1) % 26;
+	unsigned int p2 = (starts[k][1] + c2) % 26;
+	unsigned int p3 = (starts[k][2] + (offset / 676)) % 26;
+	for(size_t i = 0; i < len; i++){
+	  unsigned int x = t.plugboard[in[i]];
+	  x = t.rotor[0][(x + 26 - p1) % 26];
+	  x = t.rotor[1][(x + 26 - p2) % 26];
+	  x = t.rotor[2][(x + 26 - p3) % 26];
+	  x = t.reflector[x];
+	  x = (t.rotorInverse[2][x] + p3) % 26;
+	  x = (t.rotorInverse[1][x] + p2) % 26;
+	  x = (t.rotorInverse[0][x] + p1) % 26;
+	  out[i * stride + k] = t.plugboardInverse[x];
+
+	  /*オドメータ式にスクランブラーを進める*/
+	  if(++p1 == 26) p1 = 0;
+	  if(++c1 == 26){
+		c1 = 0;
+		if(++p2 == 26) p2 = 0;
+		if(++c2 == 26){
+		  c2 = 0;
+		  if(++p3 == 26) p3 = 0;
+		}
+	  }
+	}
+  }
+}
+
+/**
+ * @brief スカラでクリブ(推測した平文の断片)を置ける位置を選別する
+ * @param [in] ct 暗号文(アルファベットのID)
+ * @param [in] positions 調べる位置の数(暗号文の文字数 - クリブの文字数 + 1)
+ * @param [in] crib クリブ(アルファベットのID)
+ * @param [in] crib_len クリブの文字数
+ * @param [out] ok 位置jにクリブを置けるならok[j] = 1,置けなければ0
+ * @return なし
+ * @detail リフレクターに自分自身へ対応する文字がないので,エニグマはどの文字も
+ *         自分自身には暗号化しない.クリブと暗号文で同じ文字が重なる位置は除ける
+ */
+inline void ScalarScreenCrib(const uint8_t *ct, size_t positions, const uint8_t *crib,
+							 size_t crib_len, uint8_t *ok){
+  for(size_t j = 0; j < positions; j++){
+	uint8_t hit = 0;
+	for(size_t i = 0; i < crib_len; i++){
+	  hit |= (ct[j + i] == crib[i]);
+	}
+	ok[j] = !hit;
+  }
+}
+
+#ifdef ENIGMA_SIMD_X86
+/**
+ * @brief 26要素の表を16文字分同時に引く(SSE4.1)
+ * @param [in] lo 表の0~15番目
+ * @param [in] hi 表の16~25番目
+ * @param [in] idx 添字(0~25)
+ * @return 引いた値
+ */
+__attribute__((target("sse4.1")))
+inline __m128i Lookup26(const __m128i lo, const __m128i hi, const __m128i idx){
+  __m128i is_hi = _mm_cmpgt_epi8(idx, _mm_set1_epi8(15));
+  return _mm_blendv_epi8(_mm_shuffle_epi8(lo, idx), _mm_shuffle_epi8(hi, idx), is_hi);
+}
+
+/**
+ * @brief (x - p) mod 26 を16文字分同時に求める(x, p は0~25)
+ */
+__attribute__((target("sse4.1")))
+inline __m128i SubMod26(const __m128i x, const __m128i p){
+  __m128i d = _mm_sub_epi8(x, p);
+  return _mm_add_epi8(d, _mm_and_si128(_mm_cmplt_epi8(d, _mm_setzero_si128()), _mm_set1_epi8(26)));
+}
+
+/**
+ * @brief (x + p) mod 26 を16文字分同時に求める(x, p は0~25)
+ */
+__attribute__((target("sse4.1")))
+inline __m128i AddMod26(const __m128i x, const __m128i p){
+  __m128i s = _mm_add_epi8(x, p);
+  return _mm_sub_epi8(s, _mm_and_si128(_mm_cmpgt_epi8(s, _mm_set1_epi8(25)), _mm_set1_epi8(26)));
+}
+
+/**
+ * @brief 16バイトの表を読む
+ */
+__attribute__((target("sse4.1")))
+inline __m128i LoadTable16(const uint8_t *p){
+  return _mm_loadu_si128((const __m128i *)p);
+}
+
+/**
+ * @brief SSE4.1で一括暗号化を行う(16文字ずつ,端数はスカラ)
+ * @param [in] t 換字表
+ * @param [in] in 入力(アルファベットのID)
+ * @param [out] out 出力(アルファベットのID)
+ * @param [in] len 文字数
+ * @param [in] offset 先頭の文字がキーを合わせてから何文字目か
+ * @return なし
+ */
+__attribute__((target("sse4.1")))
+inline void Sse41BatchEncipher(const BatchTables &t, const uint8_t *in, uint8_t *out,
+							   size_t len, unsigned long long offset){
+  const __m128i plug_lo = LoadTable16(t.plugboard), plug_hi = LoadTable16(t.plugboard + 16);
+  const __m128i pinv_lo = LoadTable16(t.plugboardInverse), pinv_hi = LoadTable16(t.plugboardInverse + 16);
+  __m128i rot_lo[3], rot_hi[3], rinv_lo[3], rinv_hi[3], start[3];
+  for(int r = 0; r < 3; r++){
+	rot_lo[r] = LoadTable16(t.rotor[r]);
+	rot_hi[r] = LoadTable16(t.rotor[r] + 16);
+	rinv_lo[r] = LoadTable16(t.rotorInverse[r]);
+	rinv_hi[r] = LoadTable16(t.rotorInverse[r] + 16);
+	start[r] = _mm_set1_epi8(t.start[r]);
+  }
+  const __m128i ref_lo = LoadTable16(t.reflector), ref_hi = LoadTable16(t.reflector + 16);
+
+  /*レーンごとの回転数(c1: n mod 26, c2: n/26 mod 26, c3: n/676 mod 26)*/
+  uint8_t c[3][16];
+  for(int l = 0; l < 16; l++){
+	unsigned long long n = offset + l;
+	c[0][l] = n % 26;
+	c[1][l] = (n / 26) % 26;
+	c[2][l] = (n / 676) % 26;
+  }
+  __m128i c1 = _mm_loadu_si128((const __m128i *)c[0]);
+  __m128i c2 = _mm_loadu_si128((const __m128i *)c[1]);
+  __m128i c3 = _mm_loadu_si128((const __m128i *)c[2]);
+  const __m128i k16 = _mm_set1_epi8(16), k25 = _mm_set1_epi8(25), k26 = _mm_set1_epi8(26);
+
+  size_t i = 0;
+  for(; i + 16 <= len; i += 16){
+	__m128i p1 = AddMod26(c1, start[0]);
+	__m128i p2 = AddMod26(c2, start[1]);
+	__m128i p3 = AddMod26(c3, start[2]);
+	__m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+	x = Lookup26(plug_lo, plug_hi, x);
+	x = Lookup26(rot_lo[0], rot_hi[0], SubMod26(x, p1));
+	x = Lookup26(rot_lo[1], rot_hi[1], SubMod26(x, p2));
+	x = Lookup26(rot_lo[2], rot_hi[2], SubMod26(x, p3));
+	x = Lookup26(ref_lo, ref_hi, x);
+	x = AddMod26(Lookup26(rinv_lo[2], rinv_hi[2], x), p3);
+	x = AddMod26(Lookup26(rinv_lo[1], rinv_hi[1], x), p2);
+	x = AddMod26(Lookup26(rinv_lo[0], rinv_hi[0], x), p1);
+	x = Lookup26(pinv_lo, pinv_hi, x);
+	_mm_storeu_si128((__m128i *)(out + i), x);
+
+	/*各レーンを16文字分進める(繰り上がりはマスク(-1)の減算で足す)*/
+	c1 = _mm_add_epi8(c1, k16);
+	__m128i carry1 = _mm_cmpgt_epi8(c1, k25);
+	c1 = _mm_sub_epi8(c1, _mm_and_si128(carry1, k26));
+	c2 = _mm_sub_epi8(c2, carry1);
+	__m128i carry2 = _mm_cmpgt_epi8(c2, k25);
+	c2 = _mm_sub_epi8(c2, _mm_and_si128(carry2, k26));
+	c3 = _mm_sub_epi8(c3, carry2);
+	c3 = _mm_sub_epi8(c3, _mm_and_si128(_mm_cmpgt_epi8(c3, k25), k26));
+  }
+  ScalarBatchEncipher(t, in + i, out + i, len - i, offset + i);
+}
+
+/**
+ * @brief 複数のキーの位置をレーンごとに並べて読む(構造体の配列を配列の構造体に直す)
+ * @param [in] starts キーごとのキーを合わせた直後のring1~3の位置
+ * @param [in] lanes レーン数(16か32)
+ * @param [out] soa soa[r][l]にレーンlのringr+1の位置を置く
+ * @return なし
+ */
+inline void TransposeStarts(const uint8_t (*starts)[3], const int lanes, uint8_t (*soa)[32]){
+  for(int l = 0; l < lanes; l++){
+	for(int r = 0; r < 3; r++){
+	  soa[r][l] = starts[l][r];
+	}
+  }
+}
+
+/**
+ * @brief SSE4.1で1つの文字列を16個のキーで一度に暗号化する
+ * @param [in] t 換字表(startは使わない)
+ * @param [in] starts キーごとのキーを合わせた直後のring1~3の位置(16要素)
+ * @param [in] in 入力(アルファベットのID)
+ * @param [in] len 文字数
+ * @param [in] offset 先頭の文字がキーを合わせてから何文字目か
+ * @param [out] out 出力(アルファベットのID).i文字目の結果をout[i * stride]から16バイト置く
+ * @param [in] stride 出力の1文字あたりのバイト数
+ * @return なし
+ * @detail どのキーも同じ文字数だけ進むので,回転数は全レーン共通のスカラで持ち,
+ *         キーを合わせた直後の位置だけをレーンごとに持つ
+ */
+__attribute__((target("sse4.1")))
+inline void Sse41MultiKeyEncipher(const BatchTables &t, const uint8_t (*starts)[3],
+								  const uint8_t *in, size_t len, unsigned long long offset,
+								  uint8_t *out, size_t stride){
+  __m128i rot_lo[3], rot_hi[3], rinv_lo[3], rinv_hi[3], start[3];
+  uint8_t soa[3][32];
+  TransposeStarts(starts, 16, soa);
+  for(int r = 0; r < 3; r++){
+	rot_lo[r] = LoadTable16(t.rotor[r]);
+	rot_hi[r] = LoadTable16(t.rotor[r] + 16);
+	rinv_lo[r] = LoadTable16(t.rotorInverse[r]);
+	rinv_hi[r] = LoadTable16(t.rotorInverse[r] + 16);
+	start[r] = LoadTable16(soa[r]);
+  }
+  const __m128i ref_lo = LoadTable16(t.reflector), ref_hi = LoadTable16(t.reflector + 16);
+  const __m128i pinv_lo = LoadTable16(t.plugboardInverse), pinv_hi = LoadTable16(t.plugboardInverse + 16);
+
+  unsigned int c1 = offset % 26, c2 = (offset / 26) % 26, c3 = (offset / 676) % 26;
+  for(size_t i = 0; i < len; i++){
+	__m128i p1 = AddMod26(start[0], _mm_set1_epi8(c1));
+	__m128i p2 = AddMod26(start[1], _mm_set1_epi8(c2));
+	__m128i p3 = AddMod26(start[2], _mm_set1_epi8(c3));
+	__m128i x = _mm_set1_epi8(t.plugboard[in[i]]);
+	x = Lookup26(rot_lo[0], rot_hi[0], SubMod26(x, p1));
+	x = Lookup26(rot_lo[1], rot_hi[1], SubMod26(x, p2));
+	x = Lookup26(rot_lo[2], rot_hi[2], SubMod26(x, p3));
+	x = Lookup26(ref_lo, ref_hi, x);
+	x = AddMod26(Lookup26(rinv_lo[2], rinv_hi[2], x), p3);
+	x = AddMod26(Lookup26(rinv_lo[1], rinv_hi[1], x), p2);
+	x = AddMod26(Lookup26(rinv_lo[0], rinv_hi[0], x), p1);
+	x = Lookup26(pinv_lo, pinv_hi, x);
+	_mm_storeu_si128((__m128i *)(out + i * stride), x);
+
+	/*オドメータ式に全レーン共通の回転数を進める*/
+	if(++c1 == 26){
+	  c1 = 0;
+	  if(++c2 == 26){
+		c2 = 0;
+		if(++c3 == 26) c3 = 0;
+	  }
+	}
+  }
+}
+
+/**
+ * @brief SSE4.1でクリブを置ける位置を選別する(16位置ずつ,端数はスカラ)
+ * @param [in] ct 暗号文(アルファベットのID)
+ * @param [in] positions 調べる位置の数(暗号文の文字数 - クリブの文字数 + 1)
+ * @param [in] crib クリブ(アルファベットのID)
+ * @param [in] crib_len クリブの文字数
+ * @param [out] ok 位置jにクリブを置けるならok[j] = 1,置けなければ0
+ * @return なし
+ */
+__attribute__((target("sse4.1")))
+inline void Sse41ScreenCrib(const uint8_t *ct, size_t positions, const uint8_t *crib,
+							size_t crib_len, uint8_t *ok){
+  const __m128i one = _mm_set1_epi8(1);
+  size_t j = 0;
+  for(; j + 16 <= positions; j += 16){
+	__m128i hit = _mm_setzero_si128();
+	for(size_t i = 0; i < crib_len; i++){
+	  hit = _mm_or_si128(hit, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(ct + j + i)),
+											 _mm_set1_epi8(crib[i])));
+	}
+	_mm_storeu_si128((__m128i *)(ok + j), _mm_andnot_si128(hit, one));
+  }
+  ScalarScreenCrib(ct + j, positions - j, crib, crib_len, ok + j);
+}
+
+/**
+ * @brief 26要素の表を32文字分同時に引く(AVX2)
+ * @param [in] lo 表の0~15番目(両レーンに複製済み)
+ * @param [in] hi 表の16~25番目(両レーンに複製済み)
+ * @param [in] idx 添字(0~25)
+ * @return 引いた値
+ */
+__attribute__((target("avx2")))
+inline __m256i Lookup26(const __m256i lo, const __m256i hi, const __m256i idx){
+  __m256i is_hi = _mm256_cmpgt_epi8(idx, _mm256_set1_epi8(15));
+  return _mm256_blendv_epi8(_mm256_shuffle_epi8(lo, idx), _mm256_shuffle_epi8(hi, idx), is_hi);
+}
+
+/**
+ * @brief (x - p) mod 26 を32文字分同時に求める(x, p は0~25)
+ */
+__attribute__((target("avx2")))
+inline __m256i SubMod26(const __m256i x, const __m256i p){
+  __m256i d = _mm256_sub_epi8(x, p);
+  return _mm256_add_epi8(d, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_setzero_si256(), d), _mm256_set1_epi8(26)));
+}
+
+/**
+ * @brief (x + p) mod 26 を32文字分同時に求める(x, p は0~25)
+ */
+__attribute__((target("avx2")))
+inline __m256i AddMod26(const __m256i x, const __m256i p){
+  __m256i s = _mm256_add_epi8(x, p);
+  return _mm256_sub_epi8(s, _mm256_and_si256(_mm256_cmpgt_epi8(s, _mm256_set1_epi8(25)), _mm256_set1_epi8(26)));
+}
+
+/**
+ * @brief 16バイトの表を256bitレジスタの両レーンに複製して読む
+ */
+__attribute__((target("avx2")))
+inline __m256i BroadcastTable16(const uint8_t *p){
+  return _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)p));
+}
+
+/**
+ * @brief AVX2で一括暗号化を行う(32文字ずつ,端数はスカラ)
+ * @param [in] t 換字表
+ * @param [in] in 入力(アルファベットのID)
+ * @param [out] out 出力(アルファベットのID)
+ * @param [in] len 文字数
+ * @param [in] offset 先頭の文字がキーを合わせてから何文字目か
+ * @return なし
+ */
+__attribute__((target("avx2")))
+inline void Avx2BatchEncipher(const BatchTables &t, const uint8_t *in, uint8_t *out,
+							  size_t len, unsigned long long offset){
+  const __m256i plug_lo = BroadcastTable16(t.plugboard), plug_hi = BroadcastTable16(t.plugboard + 16);
+  const __m256i pinv_lo = BroadcastTable16(t.plugboardInverse), pinv_hi = BroadcastTable16(t.plugboardInverse + 16);
+  __m256i rot_lo[3], rot_hi[3], rinv_lo[3], rinv_hi[3], start[3];
+  for(int r = 0; r < 3; r++){
+	rot_lo[r] = BroadcastTable16(t.rotor[r]);
+	rot_hi[r] = BroadcastTable16(t.rotor[r] + 16);
+	rinv_lo[r] = BroadcastTable16(t.rotorInverse[r]);
+	rinv_hi[r] = BroadcastTable16(t.rotorInverse[r] + 16);
+	start[r] = _mm256_set1_epi8(t.start[r]);
+  }
+  const __m256i ref_lo = BroadcastTable16(t.reflector), ref_hi = BroadcastTable16(t.reflector + 16);
+
+  /*レーンごとの回転数(c1: n mod 26, c2: n/26 mod 26, c3: n/676 mod 26)*/
+  uint8_t c[3][32];
+  for(int l = 0; l < 32; l++){
+	unsigned long long n = offset + l;
+	c[0][l] = n % 26;
+	c[1][l] = (n / 26) % 26;
+	c[2][l] = (n / 676) % 26;
+  }
+  __m256i c1 = _mm256_loadu_si256((const __m256i *)c[0]);
+  __m256i c2 = _mm256_loadu_si256((const __m256i *)c[1]);
+  __m256i c3 = _mm256_loadu_si256((const __m256i *)c[2]);
+  const __m256i k6 = _mm256_set1_epi8(6), k25 = _mm256_set1_epi8(25), k26 = _mm256_set1_epi8(26);
+  const __m256i one = _mm256_set1_epi8(1);
+
+  size_t i = 0;
+  for(; i + 32 <= len; i += 32){
+	__m256i p1 = AddMod26(c1, start[0]);
+	__m256i p2 = AddMod26(c2, start[1]);
+	__m256i p3 = AddMod26(c3, start[2]);
+	__m256i x = _mm256_loadu_si256((const __m256i *)(in + i));
+	x = Lookup26(plug_lo, plug_hi, x);
+	x = Lookup26(rot_lo[0], rot_hi[0], SubMod26(x, p1));
+	x = Lookup26(rot_lo[1], rot_hi[1], SubMod26(x, p2));
+	x = Lookup26(rot_lo[2], rot_hi[2], SubMod26(x, p3));
+	x = Lookup26(ref_lo, ref_hi, x);
+	x = AddMod26(Lookup26(rinv_lo[2], rinv_hi[2], x), p3);
+	x = AddMod26(Lookup26(rinv_lo[1], rinv_hi[1], x), p2);
+	x = AddMod26(Lookup26(rinv_lo[0], rinv_hi[0], x), p1);
+	x = Lookup26(pinv_lo, pinv_hi, x);
+	_mm256_storeu_si256((__m256i *)(out + i), x);
+
+	/*各レーンを32文字(= 26 + 6)分進める.ring2は必ず1つ,c1が繰り上がればさらに1つ進む*/
+	c1 = _mm256_add_epi8(c1, k6);
+	__m256i carry1 = _mm256_cmpgt_epi8(c1, k25);
+	c1 = _mm256_sub_epi8(c1, _mm256_and_si256(carry1, k26));
+	c2 = _mm256_sub_epi8(_mm256_add_epi8(c2, one), carry1);
+	__m256i carry2 = _mm256_cmpgt_epi8(c2, k25);
+	c2 = _mm256_sub_epi8(c2, _mm256_and_si256(carry2, k26));
+	c3 = _mm256_sub_epi8(c3, carry2);
+	c3 = _mm256_sub_epi8(c3, _mm256_and_si256(_mm256_cmpgt_epi8(c3, k25), k26));
+  }
+  ScalarBatchEncipher(t, in + i, out + i, len - i, offset + i);
+}
+
+/**
+ * @brief AVX2で1つの文字列を32 x V個のキーで一度に暗号化する
+ * @param [in] t 換字表(startは使わない)
+ * @param [in] starts キーごとのキーを合わせた直後のring1~3の位置(32 x V要素)
+ * @param [in] in 入力(アルファベットのID)
+ * @param [in] len 文字数
+ * @param [in] offset 先頭の文字がキーを合わせてから何文字目か
+ * @param [out] out 出力(アルファベットのID).i文字目の結果をout[i * stride]から32 x Vバイト置く
+ * @param [in] stride 出力の1文字あたりのバイト数
+ * @return なし
+ * @detail V組のレーンは互いに独立なので,1文字ごとに交互に進めて命令の待ち時間を隠す
+ */
+template <int V>
+__attribute__((target("avx2")))
+inline void Avx2MultiKeyEncipher(const BatchTables &t, const uint8_t (*starts)[3],
+								 const uint8_t *in, size_t len, unsigned long long offset,
+								 uint8_t *out, size_t stride){
+  __m256i rot_lo[3], rot_hi[3], rinv_lo[3], rinv_hi[3], start[V][3];
+  for(int v = 0; v < V; v++){
+	uint8_t soa[3][32];
+	TransposeStarts(starts + v * 32, 32, soa);
+	for(int r = 0; r < 3; r++){
+	  start[v][r] = _mm256_loadu_si256((const __m256i *)soa[r]);
+	}
+  }
+  for(int r = 0; r < 3; r++){
+	rot_lo[r] = BroadcastTable16(t.rotor[r]);
+	rot_hi[r] = BroadcastTable16(t.rotor[r] + 16);
+	rinv_lo[r] = BroadcastTable16(t.rotorInverse[r]);
+	rinv_hi[r] = BroadcastTable16(t.rotorInverse[r] + 16);
+  }
+  const __m256i ref_lo = BroadcastTable16(t.reflector), ref_hi = BroadcastTable16(t.reflector + 16);
+  const __m256i pinv_lo = BroadcastTable16(t.plugboardInverse), pinv_hi = BroadcastTable16(t.plugboardInverse + 16);
+
+  unsigned int c1 = offset % 26, c2 = (offset / 26) % 26, c3 = (offset / 676) % 26;
+  for(size_t i = 0; i < len; i++){
+	const __m256i d1 = _mm256_set1_epi8(c1), d2 = _mm256_set1_epi8(c2), d3 = _mm256_set1_epi8(c3);
+	const __m256i plug = _mm256_set1_epi8(t.plugboard[in[i]]);
+	for(int v = 0; v < V; v++){
+	  __m256i p1 = AddMod26(start[v][0], d1);
+	  __m256i p2 = AddMod26(start[v][1], d2);
+	  __m256i p3 = AddMod26(start[v][2], d3);
+	  __m256i x = Lookup26(rot_lo[0], rot_hi[0], SubMod26(plug, p1));
+	  x = Lookup26(rot_lo[1], rot_hi[1], SubMod26(x, p2));
+	  x = Lookup26(rot_lo[2], rot_hi[2], SubMod26(x, p3));
+	  x = Lookup26(ref_lo, ref_hi, x);
+	  x = AddMod26(Lookup26(rinv_lo[2], rinv_hi[2], x), p3);
+	  x = AddMod26(Lookup26(rinv_lo[1], rinv_hi[1], x), p2);
+	  x = AddMod26(Lookup26(rinv_lo[0], rinv_hi[0], x), p1);
+	  x = Lookup26(pinv_lo, pinv_hi, x);
+	  _mm256_storeu_si256((__m256i *)(out + i * stride + v * 32), x);
+	}
+
+	/*オドメータ式に全レーン共通の回転数を進める*/
+	if(++c1 == 26){
+	  c1 = 0;
+	  if(++c2 == 26){
+		c2 = 0;
+		if(++c3 == 26) c3 = 0;
+	  }
+	}
+  }
+}
+
+/**
+ * @brief AVX2でクリブを置ける位置を選別する(32位置ずつ,端数はスカラ)
+ * @param [in] ct 暗号文(アルファベットのID)
+ * @param [in] positions 調べる位置の数(暗号文の文字数 - クリブの文字数 + 1)
+ * @param [in] crib クリブ(アルファベットのID)
+ * @param [in] crib_len クリブの文字数
+ * @param [out] ok 位置jにクリブを置けるならok[j] = 1,置けなければ0
+ * @return なし
+ */
+__attribute__((target("avx2")))
+inline void Avx2ScreenCrib(const uint8_t *ct, size_t positions, const uint8_t *crib,
+						   size_t crib_len, uint8_t *ok){
+  const __m256i one = _mm256_set1_epi8(1);
+  size_t j = 0;
+  for(; j + 32 <= positions; j += 32){
+	__m256i hit = _mm256_setzero_si256();
+	for(size_t i = 0; i < crib_len; i++){
+	  hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(ct + j + i)),
+												   _mm256_set1_epi8(crib[i])));
+	}
+	_mm256_storeu_si256((__m256i *)(ok + j), _mm256_andnot_si256(hit, one));
+  }
+  ScalarScreenCrib(ct + j, positions - j, crib, crib_len, ok + j);
+}
+#endif // ENIGMA_SIMD_X86
+
+/**
+ * @brief 実行中のCPUで使える最速のカーネルを返す
+ * @param なし
+ * @return カーネルの種類
+ */
+inline BatchKernel DetectBatchKernel(){
+#ifdef ENIGMA_SIMD_X86
+  static const BatchKernel kernel =
+	__builtin_cpu_supports("avx2") ? BATCH_KERNEL_AVX2 :
+	__builtin_cpu_supports("sse4.1") ? BATCH_KERNEL_SSE41 : BATCH_KERNEL_SCALAR;
+  return kernel;
+#else
+  return BATCH_KERNEL_SCALAR;
+#endif
+}
+
+/**
+ * @brief 指定のカーネルで一括暗号化を行う
+ * @param [in] t 換字表
+ * @param [in] in 入力(アルファベットのID)
+ * @param [out] out 出力(アルファベットのID)
+ * @param [in] len 文字数
+ * @param [in] offset 先頭の文字がキーを合わせてから何文字目か
+ * @param [in] kernel 使うカーネル(CPUが対応していなければスカラで処理する)
+ * @return なし
+ */
+inline void BatchEncipher(const BatchTables &t, const uint8_t *in, uint8_t *out,
+						  size_t len, unsigned long long offset,
+						  const BatchKernel kernel = DetectBatchKernel()){
+#ifdef ENIGMA_SIMD_X86
+  if(kernel >= BATCH_KERNEL_AVX2 && DetectBatchKernel() >= BATCH_KERNEL_AVX2){
+	Avx2BatchEncipher(t, in, out, len, offset);
+	return;
+  }
+  if(kernel >= BATCH_KERNEL_SSE41 && DetectBatchKernel() >= BATCH_KERNEL_SSE41){
+	Sse41BatchEncipher(t, in, out, len, offset);
+	return;
+  }
+#endif
+  ScalarBatchEncipher(t, in, out, len, offset);
+}
+
+/**
+ * @brief 指定のカーネルで1つの文字列を複数のキーで一度に暗号化する
+ * @param [in] t 換字表(startは使わない)
+ * @param [in] starts キーごとのキーを合わせた直後のring1~3の位置(keys要素)
+ * @param [in] keys キーの数(16や32の倍数だと端数がスカラにならず速い)
+ * @param [in] in 入力(アルファベットのID)
+ * @param [in] len 文字数
+ * @param [in] offset 先頭の文字がキーを合わせてから何文字目か
+ * @param [out] out 出力(アルファベットのID).i文字目のキーkの結果をout[i * keys + k]に置く
+ * @param [in] kernel 使うカーネル(CPUが対応していなければスカラで処理する)
+ * @return なし
+ * @detail キーをカーネルのレーン数(AVX2は64か32,SSE4.1は16)ずつまとめ,各レーンの機械を
+ *         同じ文字で同時に進める
+ */
+inline void MultiKeyEncipher(const BatchTables &t, const uint8_t (*starts)[3], size_t keys,
+							 const uint8_t *in, size_t len, unsigned long long offset,
+							 uint8_t *out, const BatchKernel kernel = DetectBatchKernel()){
+  size_t k = 0;
+#ifdef ENIGMA_SIMD_X86
+  if(kernel >= BATCH_KERNEL_AVX2 && DetectBatchKernel() >= BATCH_KERNEL_AVX2){
+	for(; k + 64 <= keys; k += 64){
+	  Avx2MultiKeyEncipher<2>(t, starts + k, in, len, offset, out + k, keys);
+	}
+	for(; k + 32 <= keys; k += 32){
+	  Avx2MultiKeyEncipher<1>(t, starts + k, in, len, offset, out + k, keys);
+	}
+  }
+  if(kernel >= BATCH_KERNEL_SSE41 && DetectBatchKernel() >= BATCH_KERNEL_SSE41){
+	for(; k + 16 <= keys; k += 16){
+	  Sse41MultiKeyEncipher(t, starts + k, in, len, offset, out + k, keys);
+	}
+  }
+#endif
+  /*端数のキーはスカラで処理し,同じ出力の並びに書き込む*/
+  ScalarMultiKeyEncipher(t, starts + k, keys - k, in, len, offset, out + k, keys);
+}
+
+/**
+ * @brief 指定のカーネルでクリブを置ける位置を選別する
+ * @param [in] ct 暗号文(アルファベットのID)
+ * @param [in] positions 調べる位置の数(暗号文の文字数 - クリブの文字数 + 1)
+ * @param [in] crib クリブ(アルファベットのID)
+ * @param [in] crib_len クリブの文字数
+ * @param [out] ok 位置jにクリブを置けるならok[j] = 1,置けなければ0
+ * @param [in] kernel 使うカーネル(CPUが対応していなければスカラで処理する)
+ * @return なし
+ */
+inline void ScreenCrib(const uint8_t *ct, size_t positions, const uint8_t *crib, size_t crib_len,
+					   uint8_t *ok, const BatchKernel kernel = DetectBatchKernel()){
+#ifdef ENIGMA_SIMD_X86
+  if(kernel >= BATCH_KERNEL_AVX2 && DetectBatchKernel() >= BATCH_KERNEL_AVX2){
+	Avx2ScreenCrib(ct, positions, crib, crib_len, ok);
+	return;
+  }
+  if(kernel >= BATCH_KERNEL_SSE41 && DetectBatchKernel() >= BATCH_KERNEL_SSE41){
+	Sse41ScreenCrib(ct, positions, crib, crib_len, ok);
+	return;
+  }
+#endif
+  ScalarScreenCrib(ct, positions, crib, crib_len, ok);
+}
+
+#endif // ENIGMA_SIMD_H
@@ -0,0 +1,284 @@
+/**
+ * @brief 処理の段階ごとの時間と件数の計測(--stats)
+ * @author Hirokazu Kiyomaru
+ * @attention g++ -std=c++11 -DENIGMA_STATS としてコンパイルしたときだけ計測する.
+ *            計測するときはenigma_alloc.hをインクルードするので,enigma.hはプログラム中の
+ *            1つの翻訳単位からだけインクルードすること
+ * @file enigma_stats.h
+ * @detail ENIGMA_STAGEは,そのブロックを抜けるまでの時間とヒープ領域の確保回数を段階ごとに
+ *         足し込む.ENIGMA_COUNTは件数を足し込む.ENIGMA_STATSを定義しなければどちらも
+ *         空になり,計測のための処理は一切残らない
+ */
+#ifndef ENIGMA_STATS_H
+#define ENIGMA_STATS_H
+
+//C++の標準ライブラリ
+#include <stdint.h>
+#include <string.h>
+#include <cerrno>
+#include <string>
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#ifdef ENIGMA_STATS
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "enigma_alloc.h"
+#endif
+
+/**
+ * @brief 計測する処理の段階
+ * @detail 段階は入れ子にしない(メインスレッドの粗い単位で計る)
+ */
+enum StatStage{
+  STAGE_PARSE,   //オプションと入力文字列の解析(GetOption)
+  STAGE_READ,    //入力の読み込みと正規化
+  STAGE_ENCRYPT, //暗号化(変換経過の表示を含む)
+  STAGE_WRITE,   //結果の書き出しと表示
+  STAGE_COUNT
+};
+
+/**
+ * @brief 計測する件数
+ */
+enum StatCounter{
+  COUNTER_BYTES_READ,       //読み込んだバイト数
+  COUNTER_CHARS_ENCRYPTED,  //暗号化した文字数
+  COUNTER_ROTOR_TURNOVERS,  //リングが1回転して次のリングを回した回数
+  COUNTER_BYTES_WRITTEN,    //書き出したバイト数
+  COUNTER_COUNT
+};
+
+/**
+ * @brief 位置offsetからn文字進める間に,リングが次のリングを回す回数を返す
+ * @param [in] offset キーを合わせてからの文字数
+ * @param [in] n 進める文字数
+ * @return ring1とring2が1回転した回数の合計
+ * @detail RingCursor::EndCycleを1文字ずつ呼ばないエンジン(換字表,一括暗号化カーネル)で用いる
+ */
+inline unsigned long long CountTurnovers(const unsigned long long offset, const unsigned long long n){
+  return ((offset + n) / 26 - offset / 26) + ((offset + n) / 676 - offset / 676);
+}
+
+#ifdef ENIGMA_STATS
+/**
+ * @class Stats
+ * @brief 段階ごとの時間と件数を集計する(プログラムに1つ)
+ * @detail 件数は複数のスレッドから足し込むのでatomicにする.段階の時間はメインスレッドだけが足し込む.
+ *         サイクル数はperf_event_openで自プロセス(ユーザ空間)のCPUサイクルを数え,段階の前後で読む
+ */
+class Stats{
+private:
+  std::atomic<unsigned long long> counters[COUNTER_COUNT]; //件数
+  double stageSeconds[STAGE_COUNT];                        //段階ごとの秒数
+  unsigned long long stageCalls[STAGE_COUNT];              //段階に入った回数
+  unsigned long long stageAllocations[STAGE_COUNT];        //段階ごとのヒープ領域の確保回数
+  unsigned long long stageCycles[STAGE_COUNT];             //段階ごとのCPUサイクル数
+  std::chrono::steady_clock::time_point start;             //計測を始めた時刻
+  int cycleFd;                                             //CPUサイクルのカウンタ(なければ-1)
+  std::string cycleError;                                  //カウンタを開けなかった理由
+
+  /**
+   * デフォルトコンストラクタ
+   */
+  Stats() : start(std::chrono::steady_clock::now()), cycleFd(-1), cycleError(){
+	for(int i = 0; i < COUNTER_COUNT; i++){
+	  counters[i].store(0, std::memory_order_relaxed);
+	}
+	for(int i = 0; i < STAGE_COUNT; i++){
+	  stageSeconds[i] = 0.0;
+	  stageCalls[i] = 0;
+	  stageAllocations[i] = 0;
+	  stageCycles[i] = 0;
+	}
+  }
+public:
+  /**
+   * @brief 集計先を返す
+   * @param なし
+   * @return プログラムに1つの集計先
+   */
+  static Stats &Instance(){
+	static Stats stats;
+	return stats;
+  }
+
+  /**
+   * @brief 件数を足し込む
+   * @param [in] counter 件数の種類
+   * @param [in] n 足す数
+   * @return なし
+   */
+  inline void Add(const StatCounter counter, const unsigned long long n){
+	counters[counter].fetch_add(n, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief 段階の計測結果を足し込む
+   * @param [in] stage 段階
+   * @param [in] seconds 秒数
+   * @param [in] allocations ヒープ領域の確保回数
+   * @param [in] cycles CPUサイクル数
+   * @return なし
+   */
+  void AddStage(const StatStage stage, const double seconds, const unsigned long long allocations,
+				const unsigned long long cycles){
+	stageSeconds[stage] += seconds;
+	stageCalls[stage]++;
+	stageAllocations[stage] += allocations;
+	stageCycles[stage] += cycles;
+  }
+
+  /**
+   * @brief CPUサイクルのカウンタを開く
+   * @param なし
+   * @return 終了ステータス(カーネルやCPUが対応していなければ-1)
+   * @detail 後から作るスレッドの分も数える(inherit).カーネル内のサイクルは除く
+   */
+  int OpenCycleCounter(){
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = PERF_COUNT_HW_CPU_CYCLES;
+	attr.inherit = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	cycleFd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+	if(cycleFd < 0){
+	  cycleError = strerror(errno);
+	  return -1;
+	}
+	return 0;
+  }
+
+  /**
+   * @brief これまでのCPUサイクル数を返す
+   * @param なし
+   * @return CPUサイクル数(カウンタがなければ0)
+   */
+  unsigned long long ReadCycles() const{
+	unsigned long long cycles = 0;
+	if(cycleFd < 0 || read(cycleFd, &cycles, sizeof(cycles)) != sizeof(cycles)){
+	  return 0;
+	}
+	return cycles;
+  }
+
+  /**
+   * @brief 集計結果をJSONで書き出す
+   * @param [out] out 出力ストリーム
+   * @param [in] cycles サイクル数を書き出すならtrue
+   * @return なし
+   */
+  void Write(std::ostream &out, const bool cycles) const{
+	static const char *stage_names[STAGE_COUNT] = {"parse", "read", "encrypt", "write"};
+	static const char *counter_names[COUNTER_COUNT] = {"bytes_read", "chars_encrypted",
+													   "rotor_turnovers", "bytes_written"};
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	out << "{\n  \"seconds\": " << seconds << ",\n  \"stages\": {\n";
+	for(int i = 0; i < STAGE_COUNT; i++){
+	  out << "    \"" << stage_names[i] << "\": {\"seconds\": " << stageSeconds[i]
+		  << ", \"calls\": " << stageCalls[i] << ", \"allocations\": " << stageAllocations[i];
+	  if(cycles && cycleFd >= 0){
+		out << ", \"cycles\": " << stageCycles[i];
+	  }
+	  out << ((i + 1 < STAGE_COUNT) ? "},\n" : "}\n");
+	}
+	out << "  },\n  \"counters\": {\n";
+	for(int i = 0; i < COUNTER_COUNT; i++){
+	  out << "    \"" << counter_names[i] << "\": " << counters[i].load(std::memory_order_relaxed)
+		  << ((i + 1 < COUNTER_COUNT) ? ",\n" : "\n");
+	}
+	out << "  },\n  \"allocations\": " << GetAllocationCount();
+	if(cycles){
+	  unsigned long long chars = counters[COUNTER_CHARS_ENCRYPTED].load(std::memory_order_relaxed);
+	  if(cycleFd < 0){
+		out << ",\n  \"cycles_per_char\": null,\n  \"cycles_error\": \"" << cycleError << "\"";
+	  }else if(chars > 0){
+		out << ",\n  \"cycles_per_char\": " << double(stageCycles[STAGE_ENCRYPT]) / chars;
+	  }else{
+		out << ",\n  \"cycles_per_char\": null";
+	  }
+	}
+	out << "\n}" << std::endl;
+  }
+};
+
+/**
+ * @class StageTimer
+ * @brief 生存している間の時間・ヒープ領域の確保回数・CPUサイクル数を段階に足し込む
+ */
+class StageTimer{
+private:
+  StatStage stage;                                 //段階
+  std::chrono::steady_clock::time_point begin;     //始めた時刻
+  unsigned long long allocations;                  //始めたときの確保回数
+  unsigned long long cycles;                       //始めたときのサイクル数
+public:
+  /**
+   * コンストラクタ
+   * @param [in] stage 段階
+   */
+  explicit StageTimer(const StatStage stage)
+	: stage(stage), begin(std::chrono::steady_clock::now()), allocations(GetAllocationCount()),
+	  cycles(Stats::Instance().ReadCycles()){
+  }
+
+  /**
+   * デストラクタ
+   */
+  ~StageTimer(){
+	Stats &stats = Stats::Instance();
+	stats.AddStage(stage, std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count(),
+				   GetAllocationCount() - allocations, stats.ReadCycles() - cycles);
+  }
+};
+
+//集計結果を終了時に書き出すときにサイクル数も書き出すか
+static bool statsCycles = false;
+
+/**
+ * @brief 集計結果を標準エラー出力に書き出す(atexitに登録する)
+ * @param なし
+ * @return なし
+ */
+inline void WriteStatsAtExit(){
+  Stats::Instance().Write(std::cerr, statsCycles);
+}
+
+#define ENIGMA_STATS_CONCAT2(a, b) a##b
+#define ENIGMA_STATS_CONCAT(a, b) ENIGMA_STATS_CONCAT2(a, b)
+#define ENIGMA_STAGE(stage) StageTimer ENIGMA_STATS_CONCAT(stageTimer, __LINE__)(stage)
+#define ENIGMA_COUNT(counter, n) Stats::Instance().Add(counter, n)
+#else
+#define ENIGMA_STAGE(stage)
+#define ENIGMA_COUNT(counter, n)
+#endif
+
+/**
+ * @brief 終了時に集計結果を書き出すようにする(--stats)
+ * @param [in] cycles CPUサイクル数も数えるならtrue
+ * @return 終了ステータス(計測を組み込まずにコンパイルしていれば-1)
+ * @detail 集計結果は結果の出力に混ざらないよう標準エラー出力にJSONで書き出す.
+ *         サイクル数のカウンタを開けなくても,サイクル数以外は書き出す
+ */
+inline int EnableStats(const bool cycles){
+#ifdef ENIGMA_STATS
+  statsCycles = cycles;
+  if(cycles && Stats::Instance().OpenCycleCounter() < 0){
+	std::cerr << "\tCannot count CPU cycles (perf_event_open). Only the other stats are reported." << std::endl;
+  }
+  atexit(WriteStatsAtExit);
+  return 0;
+#else
+  (void)cycles;
+  std::cerr << "\t--stats needs a build with -DENIGMA_STATS. No stats are reported." << std::endl;
+  return -1;
+#endif
+}
+
+#endif // ENIGMA_STATS_H
@@ -0,0 +1,72 @@
+/**
+ * @brief エニグマのバイナリトレース(-T)を-t/-kと同じ形式で表示する
+ * @author Hirokazu Kiyomaru
+ * @attention g++ -std=c++11 -O2 としてコンパイル
+ * @file enigma_trace.cpp
+ */
+
+//C++の標準ライブラリ
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "enigma_trace.h"
+
+/**
+ * @brief 使い方を表示する
+ * @param なし
+ * @return なし
+ */
+void ShowTraceUsage(){
+  std::cerr << "\t[Usage] enigma_trace [-t | -k] TRACE_FILE\n";
+  std::cerr << "\t  option -> -t : You can show only the process of conversion.\n";
+  std::cerr << "\t            -k : You can show the key arrays and the process of conversion.\n";
+  std::cerr << "\t            (Without them, it is shown as it was recorded.)" << std::endl;
+}
+
+/**
+ * @brief デコーダのエントリポイント
+ * @param [in] argc コマンドライン引数の数
+ * @param [in] argv コマンドライン引数
+ * @return 終了ステータス
+ */
+int main(int argc, char *argv[]){
+  int kind = -1;
+  int arg = 1;
+  if(arg < argc && strcmp(argv[arg], "-t") == 0){
+	kind = TRACE_TRANSITION;
+	arg++;
+  }else if(arg < argc && strcmp(argv[arg], "-k") == 0){
+	kind = TRACE_KEY_ARRAY;
+	arg++;
+  }
+  if(arg + 1 != argc){
+	ShowTraceUsage();
+	return -1;
+  }
+
+  TraceReader reader;
+  if(reader.Open(argv[arg]) < 0){
+	return -1;
+  }
+  if(kind < 0){
+	kind = reader.getHeader().kind;
+  }
+
+  /*ブロックごとに読み,表示する文字列にまとめて書き出す*/
+  TraceRenderer renderer(reader.getHeader(), kind == TRACE_KEY_ARRAY);
+  std::vector<TraceRecord> records(TRACE_BLOCK);
+  std::string text = "";
+  renderer.Begin(text);
+  size_t count = 0;
+  while((count = reader.Read(&records[0], TRACE_BLOCK)) > 0){
+	renderer.Render(&records[0], count, text);
+	fwrite(text.data(), 1, text.length(), stdout);
+	text.clear();
+  }
+  renderer.End(text);
+  fwrite(text.data(), 1, text.length(), stdout);
+  return (fflush(stdout) == 0) ? 0 : -1;
+}
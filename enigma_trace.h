@@ -0,0 +1,329 @@
+/**
+ * @brief 変換経過(-t/-k)のバイナリトレースの記録と表示
+ * @author Hirokazu Kiyomaru
+ * @attention g++ -std=c++11 としてコンパイル
+ * @file enigma_trace.h
+ * @detail トレースは,TraceHeaderに続いて記録した文字ごとのTraceRecordを並べたバイナリファイル.
+ *         レコードはリングの位置と各部品を通った後のIDだけを持つ13バイトで,キー配列は
+ *         ヘッダの配線とリングの位置から表示するときに組み立てる.表示(TraceRenderer)は
+ *         -t/-kの出力と同じ文字列をまとめて作るので,文字ごとに出力を吐き出さない.
+ *         範囲(-R)や間隔(-E)を指定したときは,記録した文字の位置をヘッダのfirstとeveryから求める
+ */
+#ifndef ENIGMA_TRACE_H
+#define ENIGMA_TRACE_H
+
+//C++の標準ライブラリ
+#include <stdint.h>
+#include <string.h>
+#include <climits>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include "enigma_simd.h"
+
+//トレースのファイルの先頭の識別子
+static const char TRACE_MAGIC[4] = {'E', 'N', 'T', 'R'};
+//トレースのファイルの形式の版
+static const uint32_t TRACE_VERSION = 2;
+//一度に記録・表示するレコードの数
+static const size_t TRACE_BLOCK = 4096;
+
+/**
+ * @brief トレースを記録したときの表示の種類
+ */
+enum TraceKind{
+  TRACE_TRANSITION = 0, //変換経過だけ(-t)
+  TRACE_KEY_ARRAY = 1   //毎回のキー配列と変換経過(-k)
+};
+
+/**
+ * @struct TraceWindow
+ * @brief トレースに記録する文字の位置(メッセージの先頭から0で数える)
+ * @detail from以上to未満のうち,fromからevery文字おきの位置を記録する
+ */
+struct TraceWindow{
+  unsigned long long from;  //記録を始める位置
+  unsigned long long to;    //記録を終える位置(この位置は含まない)
+  unsigned long long every; //記録する間隔(1なら毎文字)
+
+  /**
+   * コンストラクタ
+   * @param [in] from 記録を始める位置
+   * @param [in] to 記録を終える位置(この位置は含まない)
+   * @param [in] every 記録する間隔
+   * @detail 既定ではすべての文字を記録する
+   */
+  TraceWindow(const unsigned long long from = 0, const unsigned long long to = ULLONG_MAX,
+			  const unsigned long long every = 1) : from(from), to(to), every(every){
+  }
+
+  /**
+   * @brief 一部の文字だけを記録するかを返す
+   * @param なし
+   * @return 先頭から毎文字記録するのでなければtrue
+   */
+  inline bool Partial() const{
+	return from > 0 || every > 1;
+  }
+};
+
+/**
+ * @struct TraceHeader
+ * @brief トレースのファイルの先頭(176バイト)
+ * @detail 配線はキー配列を組み立てるために持つ.リングの配線は位置0でのもの.
+ *         k番目のレコードはメッセージのfirst + k * every文字目(0から数える)
+ */
+struct TraceHeader{
+  char magic[4];          //TRACE_MAGIC
+  uint32_t version;       //TRACE_VERSION
+  uint32_t kind;          //記録したときの表示の種類(TraceKind)
+  uint32_t reserved;      //0
+  uint64_t offset;        //メッセージの先頭がキーを合わせてから何文字目か
+  uint64_t first;         //先頭のレコードの位置(TraceWindow::from)
+  uint64_t every;         //レコードの間隔(TraceWindow::every)
+  uint8_t plugboard[26];  //プラグボードのキー配列
+  uint8_t rotor[3][26];   //ring1~3の位置0での配線
+  uint8_t reflector[26];  //リフレクターのキー配列
+  uint8_t padding[6];     //0
+};
+static_assert(sizeof(TraceHeader) == 176, "TraceHeader must be 176 bytes");
+
+/**
+ * @struct TraceRecord
+ * @brief 1文字分のトレース(13バイト)
+ * @detail idsは入力,プラグボード,ring1,ring2,ring3,リフレクター,ring3,ring2,ring1,
+ *         プラグボード(出力)の順に,それぞれを通った後のアルファベットのID
+ */
+struct TraceRecord{
+  uint8_t pos[3];  //ring1~3の位置
+  uint8_t ids[10]; //各部品を通った後のID
+};
+static_assert(sizeof(TraceRecord) == 13, "TraceRecord must be 13 bytes");
+
+/**
+ * @brief トレースのヘッダを作る
+ * @param [in] tables 全部品の表(EnigmaConfig::ExportTables)
+ * @param [in] kind 表示の種類
+ * @param [in] offset メッセージの先頭がキーを合わせてから何文字目か
+ * @param [in] window 記録する文字の位置
+ * @param [out] header 作ったヘッダ
+ * @return なし
+ */
+inline void MakeTraceHeader(const BatchTables &tables, const TraceKind kind,
+							const unsigned long long offset, const TraceWindow &window,
+							TraceHeader &header){
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, TRACE_MAGIC, 4);
+  header.version = TRACE_VERSION;
+  header.kind = kind;
+  header.offset = offset;
+  header.first = window.from;
+  header.every = window.every;
+  memcpy(header.plugboard, tables.plugboard, 26);
+  for(int i = 0; i < 3; i++){
+	memcpy(header.rotor[i], tables.rotor[i], 26);
+  }
+  memcpy(header.reflector, tables.reflector, 26);
+}
+
+/**
+ * @class TraceWriter
+ * @brief トレースをファイルに書き出す
+ * @detail レコードはブロック単位で受け取り,ストリームのバッファを通して書き出す
+ */
+class TraceWriter{
+private:
+  std::ofstream ofs;    //書き出し先
+  std::string fileName; //ファイル名
+public:
+  /**
+   * @brief ファイルを開いてヘッダを書き出す
+   * @param [in] file_name トレースのファイル名
+   * @param [in] header ヘッダ
+   * @return 終了ステータス
+   */
+  int Open(const std::string &file_name, const TraceHeader &header){
+	fileName = file_name;
+	ofs.open(file_name, std::ios::binary);
+	ofs.write((const char *)&header, sizeof(header));
+	if(ofs.fail()){
+	  std::cerr << "\tCannot write the trace. > " << file_name << std::endl;
+	  return -1;
+	}
+	return 0;
+  }
+
+  /**
+   * @brief レコードを書き出す
+   * @param [in] records レコード
+   * @param [in] count レコードの数
+   * @return なし
+   */
+  void Write(const TraceRecord *records, const size_t count){
+	ofs.write((const char *)records, count * sizeof(TraceRecord));
+  }
+
+  /**
+   * @brief ファイルを閉じる
+   * @param なし
+   * @return 終了ステータス(書き出しに失敗していれば-1)
+   */
+  int Close(){
+	ofs.close();
+	if(ofs.fail()){
+	  std::cerr << "\tCannot write the trace. > " << fileName << std::endl;
+	  return -1;
+	}
+	return 0;
+  }
+};
+
+/**
+ * @class TraceReader
+ * @brief トレースのファイルを読む
+ */
+class TraceReader{
+private:
+  std::ifstream ifs;  //読み込み元
+  TraceHeader header; //ヘッダ
+public:
+  /**
+   * @brief ファイルを開いてヘッダを読む
+   * @param [in] file_name トレースのファイル名
+   * @return 終了ステータス
+   */
+  int Open(const std::string &file_name){
+	ifs.open(file_name, std::ios::binary);
+	if(ifs.fail()){
+	  std::cerr << "\tFile cannot open. > " << file_name << std::endl;
+	  return -1;
+	}
+	ifs.read((char *)&header, sizeof(header));
+	if(ifs.gcount() != sizeof(header) || memcmp(header.magic, TRACE_MAGIC, 4) != 0
+	   || header.version != TRACE_VERSION || header.kind > TRACE_KEY_ARRAY || header.every == 0){
+	  std::cerr << "\tInvalid trace. > " << file_name << std::endl;
+	  return -1;
+	}
+	return 0;
+  }
+
+  /**
+   * @brief レコードを読む
+   * @param [out] records 読み込み先
+   * @param [in] max 読み込むレコードの最大数
+   * @return 読み込んだレコードの数(終わりなら0)
+   */
+  size_t Read(TraceRecord *records, const size_t max){
+	ifs.read((char *)records, max * sizeof(TraceRecord));
+	return ifs.gcount() / sizeof(TraceRecord);
+  }
+
+  /**
+   * @brief headerに対するgetアクセサ
+   * @param なし
+   * @return ヘッダ
+   */
+  inline const TraceHeader &getHeader() const{
+	return header;
+  }
+};
+
+/**
+ * @class TraceRenderer
+ * @brief トレースを-t/-kと同じ形式の文字列にする
+ * @detail Begin,Renderをブロックごとに,Endの順に呼ぶ.結果は呼び出し側の文字列に追記する.
+ *         一部の文字だけを記録したトレースでは,-tの形式でも各行の末尾に何文字目かを付ける
+ */
+class TraceRenderer{
+private:
+  TraceHeader header;       //配線
+  bool keyArray;            //毎回のキー配列も表示するか(-k)
+  unsigned long long index; //次のレコードが何文字目か(1から数える)
+  bool partial;             //一部の文字だけを記録したトレースか
+
+  /**
+   * @brief キー配列を1行追記する
+   * @param [in] label 行の見出し
+   * @param [in] table キー配列(26要素)
+   * @param [in] pos 回転位置(キー配列のpos要素前から並べる)
+   * @param [out] out 追記先
+   * @return なし
+   */
+  static void AppendKeyArray(const char *label, const uint8_t *table, const int pos, std::string &out){
+	out += label;
+	out += "[ ";
+	for(int i = 0; i < 26; i++){
+	  out += char('A' + table[(i + 26 - pos) % 26]);
+	  out += ' ';
+	}
+	out += "]\n";
+  }
+public:
+  /**
+   * コンストラクタ
+   * @param [in] header ヘッダ
+   * @param [in] key_array 毎回のキー配列も表示するならtrue(-k)
+   */
+  TraceRenderer(const TraceHeader &header, const bool key_array)
+	: header(header), keyArray(key_array), index(header.first + 1),
+	  partial(TraceWindow(header.first, ULLONG_MAX, header.every).Partial()){
+  }
+
+  /**
+   * @brief 表示の先頭を追記する
+   * @param [out] out 追記先
+   * @return なし
+   */
+  void Begin(std::string &out) const{
+	if(!keyArray){
+	  out += "\tCode Conversion Process\n";
+	  out += "\t    Plg   Ri1   Ri2   Ri3   Ref   Ri3   Ri2   Ri1   Plg\n";
+	}
+  }
+
+  /**
+   * @brief レコードを表示する文字列を追記する
+   * @param [in] records レコード
+   * @param [in] count レコードの数
+   * @param [out] out 追記先
+   * @return なし
+   */
+  void Render(const TraceRecord *records, const size_t count, std::string &out){
+	for(size_t i = 0; i < count; i++, index += header.every){
+	  const TraceRecord &record = records[i];
+	  if(keyArray){
+		out += "\tKey Array : " + std::to_string(index) + "cycle\n";
+		out += "\t            [ A B C D E F G H I J K L M N O P Q R S T U V W X Y Z ]\n";
+		out += "\t              | | | | | | | | | | | | | | | | | | | | | | | | | |  \n";
+		AppendKeyArray("\t  Plugboard ", header.plugboard, 0, out);
+		AppendKeyArray("\t  Ring1     ", header.rotor[0], record.pos[0], out);
+		AppendKeyArray("\t  Ring2     ", header.rotor[1], record.pos[1], out);
+		AppendKeyArray("\t  Ring3     ", header.rotor[2], record.pos[2], out);
+		AppendKeyArray("\t  Reflector ", header.reflector, 0, out);
+		out += "\n\tCode Conversion Process\n";
+		out += "\t    Plg   Ri1   Ri2   Ri3   Ref   Ri3   Ri2   Ri1   Plg\n";
+	  }
+	  out += "\t  ";
+	  for(int s = 0; s < 9; s++){
+		out += char('A' + record.ids[s]);
+		out += " --> ";
+	  }
+	  out += char('A' + record.ids[9]);
+	  if(partial && !keyArray){
+		out += "\t(" + std::to_string(index) + "cycle)";
+	  }
+	  out += keyArray ? "\n\n" : "\n";
+	}
+  }
+
+  /**
+   * @brief 表示の末尾を追記する
+   * @param [out] out 追記先
+   * @return なし
+   */
+  void End(std::string &out) const{
+	out += "\n";
+  }
+};
+
+#endif // ENIGMA_TRACE_H